@@ -0,0 +1,86 @@
+
+#include <iostream>
+
+//configuration
+#define ASCS_SERVER_PORT	9528
+#define ASCS_CACHE_LINE_SIZE	64 //comment this to remove the paddings between field groups (the default), then compare
+//configuration
+
+#include <ascs/ext/tcp.h>
+using namespace ascs;
+using namespace ascs::ext::tcp;
+
+//measure false sharing inside sockets under multi-threaded sending and receiving.
+//each client socket is written by several producer threads (send_msg, the producer group), its IO strand (sending and receiving, the IO
+// group) and its dispatch strand (on_msg_handle, the dispatch group) at the same time, the server echoes all messages back.
+//false sharing shows up as HITM (hit modified) events, run it under perf c2c and compare with a build which didn't define
+// ASCS_CACHE_LINE_SIZE (no paddings), for example:
+// perf c2c record -- ./cache_line_benchmark && perf c2c report --stats | grep -i hitm
+//with a single CPU, there will be no difference at all. no numbers have been collected yet, that's why the paddings are opt-in.
+//usage: cache_line_benchmark [<client number=16> [<producer thread number=4> [<service thread number=4> [<duration (seconds)=10>]]]]
+
+std::atomic_size_t recv_msg_num(0);
+
+class echo_socket : public server_socket
+{
+public:
+	echo_socket(ascs::tcp::i_server& server_) : server_socket(server_) {}
+
+protected:
+	virtual bool on_msg_handle(out_msg_type& msg) {return send_msg(std::move(msg), true);}
+};
+
+class counting_socket : public client_socket
+{
+public:
+	counting_socket(i_matrix& matrix_) : client_socket(matrix_) {}
+
+protected:
+	virtual bool on_msg_handle(out_msg_type& msg) {++recv_msg_num; return true;}
+};
+
+int main(int argc, const char* argv[])
+{
+	size_t client_num = argc > 1 ? (size_t) atoi(argv[1]) : 16;
+	int producer_num = argc > 2 ? atoi(argv[2]) : 4;
+	int thread_num = argc > 3 ? atoi(argv[3]) : 4;
+	int duration = argc > 4 ? atoi(argv[4]) : 10;
+	if (0 == client_num || producer_num < 1 || thread_num < 1 || duration < 1)
+	{
+		puts("usage: cache_line_benchmark [<client number (> 0)> [<producer thread number (> 0)> [<service thread number (> 0)> [<duration (> 0)>]]]]");
+		return 1;
+	}
+
+	service_pump sp;
+	ascs::tcp::server_base<echo_socket> server_(sp);
+	ascs::tcp::multi_client_base<counting_socket> client(sp);
+	for (size_t i = 0; i < client_num; ++i)
+		client.add_socket();
+	sp.start_service(thread_num);
+	while (client.valid_size() < client_num)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	printf("cache line size: %d, " ASCS_SF " clients, %d producers, %d service threads, %d seconds.\n",
+		ASCS_CACHE_LINE_SIZE, client_num, producer_num, thread_num, duration);
+
+	std::atomic_bool running(true);
+	std::atomic_size_t send_msg_num(0);
+	std::vector<std::thread> producers;
+	for (auto i = 0; i < producer_num; ++i)
+		producers.emplace_back([&]() {
+			std::string msg(32, '0');
+			while (running)
+				client.do_something_to_all([&](ascs::tcp::multi_client_base<counting_socket>::object_ctype& item) {if (item->send_msg(msg)) ++send_msg_num;});
+		});
+
+	std::this_thread::sleep_for(std::chrono::seconds(duration));
+	running = false;
+	for (auto& item : producers)
+		item.join();
+
+	printf("sent " ASCS_SF " messages (%.0f per second), received " ASCS_SF " echoes (%.0f per second).\n",
+		send_msg_num.load(), (double) send_msg_num / duration, recv_msg_num.load(), (double) recv_msg_num / duration);
+	sp.stop_service();
+
+	return 0;
+}
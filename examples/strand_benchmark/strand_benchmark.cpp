@@ -0,0 +1,105 @@
+
+#include <iostream>
+
+//configuration
+//configuration
+
+#include <ascs/base.h>
+using namespace ascs;
+
+//measure how much a slow strand interferes with unrelated strands (head-of-line blocking).
+//one strand (the hog) keeps running busy handlers, each lasts HOG_DURATION milliseconds, meanwhile, we post one tiny handler to each of the
+// other strands (PROBE_BATCH handlers per millisecond) and measure its latency (from posting to running), a strand is considered blocked if the latency exceeds HOG_DURATION / 2.
+//with boost::asio::io_context::strand (the default of ascs), strands hash into a fixed pool of implementations, so about 1/193 of the
+// strands share the hog's implementation and get blocked. with boost::asio::strand<boost::asio::io_context::executor_type> (macro
+// ASCS_NON_HASHED_STRAND), no strand will be blocked.
+//usage: strand_benchmark [<strand number=100000> [<thread number=4> [<round number=10>]]]
+
+#define HOG_DURATION	20 //milliseconds
+#define PROBE_BATCH		1000
+
+template<typename Strand, typename Creator>
+void benchmark(const char* name, size_t strand_num, int thread_num, int round_num, Creator&& creator)
+{
+	boost::asio::io_context io_context_;
+	std::vector<std::unique_ptr<Strand>> strands;
+	strands.reserve(strand_num);
+	for (size_t i = 0; i < strand_num; ++i)
+		strands.emplace_back(new Strand(creator(io_context_)));
+
+	std::atomic_bool hogging(true);
+	std::atomic_size_t finished(0);
+	std::vector<unsigned> latencies(strand_num);
+	auto work = boost::asio::make_work_guard(io_context_);
+	std::vector<std::thread> threads;
+	for (auto i = 0; i < thread_num; ++i)
+		threads.emplace_back([&]() {io_context_.run();});
+
+	std::function<void()> hog = [&]() {
+		auto end_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(HOG_DURATION);
+		while (std::chrono::steady_clock::now() < end_time);
+		if (hogging)
+			boost::asio::post(*strands.front(), hog);
+	};
+	boost::asio::post(*strands.front(), hog);
+
+	size_t blocked_num = 0;
+	unsigned max_latency = 0;
+	uint_fast64_t latency_sum = 0;
+	for (auto round = 0; round < round_num; ++round)
+	{
+		finished = 0;
+		for (size_t i = 1; i < strand_num; ++i)
+		{
+			auto begin_time = std::chrono::steady_clock::now();
+			boost::asio::post(*strands[i], [&, i, begin_time]() {
+				latencies[i] = (unsigned) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin_time).count();
+				++finished;
+			});
+
+			if (0 == i % PROBE_BATCH) //don't flood the io_context, otherwise the latencies will be dominated by queuing
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		while (finished < strand_num - 1)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		for (size_t i = 1; i < strand_num; ++i)
+		{
+			if (latencies[i] > HOG_DURATION * 1000 / 2)
+				++blocked_num;
+			max_latency = std::max(max_latency, latencies[i]);
+			latency_sum += latencies[i];
+		}
+	}
+
+	hogging = false;
+	work.reset();
+	for (auto& item : threads)
+		item.join();
+
+	printf("%-48s blocked strands per round: %.1f, average latency: %.1f us, max latency: %.1f ms\n", name, (float) blocked_num / round_num,
+		(float) latency_sum / round_num / (strand_num - 1), max_latency / 1000.f);
+}
+
+int main(int argc, const char* argv[])
+{
+	size_t strand_num = argc > 1 ? (size_t) atoi(argv[1]) : 100000;
+	int thread_num = argc > 2 ? atoi(argv[2]) : 4;
+	int round_num = argc > 3 ? atoi(argv[3]) : 10;
+	if (strand_num < 2 || thread_num < 2 || round_num < 1)
+	{
+		puts("usage: strand_benchmark [<strand number (>= 2)> [<thread number (>= 2)> [<round number (>= 1)>]]]");
+		return 1;
+	}
+
+	printf("%d threads, " ASCS_SF " strands, %d rounds, a hog strand keeps running %d ms handlers.\n", thread_num, strand_num, round_num, HOG_DURATION);
+	benchmark<boost::asio::io_context::strand>("io_context::strand (hashed):", strand_num, thread_num, round_num,
+		[](boost::asio::io_context& io_context_) {return boost::asio::io_context::strand(io_context_);});
+#if BOOST_ASIO_VERSION > 101100
+	typedef boost::asio::strand<boost::asio::io_context::executor_type> non_hashed_strand;
+	benchmark<non_hashed_strand>("strand<executor_type> (ASCS_NON_HASHED_STRAND):", strand_num, thread_num, round_num,
+		[](boost::asio::io_context& io_context_) {return non_hashed_strand(io_context_.get_executor());});
+#endif
+
+	return 0;
+}
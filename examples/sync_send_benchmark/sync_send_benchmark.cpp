@@ -0,0 +1,90 @@
+
+#include <future>
+#include <iostream>
+
+//configuration
+#define ASCS_SERVER_PORT	9527
+#define ASCS_SYNC_SEND
+//configuration
+
+#include <ascs/ext/tcp.h>
+using namespace ascs;
+using namespace ascs::ext::tcp;
+
+//measure the rate of sync message sending.
+//first, compare the completion mechanisms alone (no network), std::promise + std::future (what sync message sending used before) and
+// sync_send_slot (what sync message sending uses now), messages are completed by the sender itself (pure overhead) or by an IO thread
+// (the sender may need to sleep, so the result depends on the scheduler and the number of CPUs).
+//then, send messages one by one via sync_send_msg on a loopback connection.
+//usage: sync_send_benchmark [<message number=100000>]
+
+template<typename Sender>
+void benchmark(const char* name, size_t msg_num, Sender&& sender)
+{
+	auto begin_time = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < msg_num; ++i)
+		sender();
+	auto used_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin_time).count();
+
+	printf("%-44s %.0f messages per second\n", name, msg_num * 1000000. / used_time);
+}
+
+int main(int argc, const char* argv[])
+{
+	size_t msg_num = argc > 1 ? (size_t) atoi(argv[1]) : 100000;
+	if (0 == msg_num)
+	{
+		puts("usage: sync_send_benchmark [<message number (> 0)>]");
+		return 1;
+	}
+
+	benchmark("std::promise + std::future (same thread):", msg_num, []() {
+		auto p = std::make_shared<std::promise<sync_call_result>>();
+		auto f = p->get_future();
+		p->set_value(sync_call_result::SUCCESS);
+		f.get();
+	});
+
+	auto pool = std::make_shared<sync_send_slot_pool>();
+	benchmark("sync_send_slot (same thread):", msg_num, [&]() {
+		auto p = pool->acquire();
+		auto waiter = p.get_waiter();
+		p->set_value(sync_call_result::SUCCESS);
+		waiter->wait(0);
+	});
+
+	boost::asio::io_context io_context_;
+	auto work = boost::asio::make_work_guard(io_context_);
+	std::thread io_thread([&]() {io_context_.run();});
+
+	benchmark("std::promise + std::future (IO thread):", msg_num, [&]() {
+		auto p = std::make_shared<std::promise<sync_call_result>>();
+		auto f = p->get_future();
+		boost::asio::post(io_context_, [p]() {p->set_value(sync_call_result::SUCCESS);});
+		f.get();
+	});
+
+	benchmark("sync_send_slot (IO thread):", msg_num, [&]() {
+		auto p = pool->acquire();
+		auto waiter = p.get_waiter();
+		boost::asio::post(io_context_, [p]() {p->set_value(sync_call_result::SUCCESS);});
+		waiter->wait(0);
+	});
+
+	work.reset();
+	io_thread.join();
+
+	service_pump sp;
+	server server_(sp);
+	single_client client(sp);
+	client.set_server_addr(ASCS_SERVER_PORT);
+	sp.start_service();
+	while (!client.is_connected())
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	std::string msg(32, '0');
+	benchmark("sync_send_msg:", msg_num, [&]() {client.sync_send_msg(msg);});
+	sp.stop_service();
+
+	return 0;
+}
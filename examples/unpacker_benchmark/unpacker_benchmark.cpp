@@ -0,0 +1,170 @@
+
+#include <random>
+#include <iostream>
+
+//configuration
+#define ASCS_SCATTERED_RECV_BUFFER //the default unpacker is a ring buffer only with this macro, comment it to compare two linear unpackers
+#ifdef ASCS_SCATTERED_RECV_BUFFER
+#define ASCS_RECV_BUFFER_TYPE std::vector<boost::asio::mutable_buffer> //scatter-gather buffers
+#endif
+//configuration
+
+#include <ascs/ext/packer.h>
+#include <ascs/ext/unpacker.h>
+using namespace ascs;
+using namespace ascs::ext;
+
+//measure the default unpacker with macro ASCS_SCATTERED_RECV_BUFFER (a ring buffer) against the one without it, which moves left behind
+// unparsed data (half-baked msg) to the head of its buffer (memmove) after every reading. no sockets involved, a pre-packed stream of
+// mixed size messages is fed to the unpackers just like boost::asio::async_read does (completion_condition, prepare_next_recv and
+// parse_msg), the kernel is supposed to always have enough data, so every reading fills all the buffers that prepare_next_recv returned.
+//usage: unpacker_benchmark [<message number=1000000> [<round number=10>]]
+
+//the default unpacker without macro ASCS_SCATTERED_RECV_BUFFER
+class memmove_unpacker : public i_unpacker<std::string>
+{
+public:
+	virtual void reset() {cur_msg_len = -1; remain_len = 0;}
+	virtual bool parse_msg(size_t bytes_transferred, container_type& msg_can)
+	{
+		remain_len += bytes_transferred;
+
+		auto pnext = raw_buff.data();
+		auto unpack_ok = true;
+		while (unpack_ok)
+			if ((size_t) -1 != cur_msg_len)
+			{
+				if (cur_msg_len > ASCS_MSG_BUFFER_SIZE || cur_msg_len < ASCS_HEAD_LEN)
+					unpack_ok = false;
+				else if (remain_len >= cur_msg_len)
+				{
+					if (cur_msg_len > ASCS_HEAD_LEN)
+						msg_can.emplace_back(std::next(pnext, ASCS_HEAD_LEN), cur_msg_len - ASCS_HEAD_LEN);
+					remain_len -= cur_msg_len;
+					std::advance(pnext, cur_msg_len);
+					cur_msg_len = -1;
+				}
+				else
+					break;
+			}
+			else if (remain_len >= ASCS_HEAD_LEN)
+			{
+				ASCS_HEAD_TYPE head;
+				memcpy(&head, pnext, ASCS_HEAD_LEN);
+				cur_msg_len = ASCS_HEAD_N2H(head);
+			}
+			else
+				break;
+
+		if (pnext == raw_buff.data())
+			unpack_ok = false;
+		else if (remain_len > 0)
+			memmove(raw_buff.data(), pnext, remain_len);
+
+		return unpack_ok;
+	}
+
+	virtual size_t completion_condition(const boost::system::error_code& ec, size_t bytes_transferred)
+	{
+		auto data_len = remain_len + bytes_transferred;
+		if ((size_t) -1 == cur_msg_len && data_len >= ASCS_HEAD_LEN)
+		{
+			ASCS_HEAD_TYPE head;
+			memcpy(&head, raw_buff.data(), ASCS_HEAD_LEN);
+			cur_msg_len = ASCS_HEAD_N2H(head);
+			if (cur_msg_len > ASCS_MSG_BUFFER_SIZE || cur_msg_len < ASCS_HEAD_LEN)
+				return 0;
+		}
+
+		return data_len >= cur_msg_len ? 0 : ASCS_MSG_BUFFER_SIZE;
+	}
+
+#ifdef ASCS_SCATTERED_RECV_BUFFER
+	virtual buffer_type prepare_next_recv() {return buffer_type(1, boost::asio::buffer(raw_buff) + remain_len);}
+#else
+	virtual buffer_type prepare_next_recv() {return boost::asio::buffer(raw_buff) + remain_len;}
+#endif
+
+private:
+	std::array<char, ASCS_MSG_BUFFER_SIZE> raw_buff;
+	size_t cur_msg_len = -1;
+	size_t remain_len{0};
+};
+
+template<typename Unpacker> void benchmark(const char* name, const std::string& stream, size_t msg_num, int round_num)
+{
+	size_t read_num = 0, bad_num = 0;
+	auto begin_time = std::chrono::steady_clock::now();
+	for (auto round = 0; round < round_num; ++round)
+	{
+		Unpacker unpacker;
+		i_unpacker<std::string>::container_type msg_can;
+		size_t pos = 0, parsed_num = 0;
+		while (pos < stream.size())
+		{
+			auto buff = unpacker.prepare_next_recv();
+			size_t bytes_transferred = 0;
+			boost::system::error_code ec;
+			auto max_size = unpacker.completion_condition(ec, 0);
+			if (max_size > 0) //the kernel always has enough data, so one read_some fills the buffers (or reaches max_size)
+			{
+				bytes_transferred = boost::asio::buffer_copy(buff, boost::asio::buffer(stream) + pos, max_size);
+				pos += bytes_transferred;
+				unpacker.completion_condition(ec, bytes_transferred);
+			}
+
+			++read_num;
+			if (!unpacker.parse_msg(bytes_transferred, msg_can))
+			{
+				++bad_num;
+				unpacker.reset();
+			}
+			parsed_num += msg_can.size();
+			msg_can.clear();
+		}
+		if (parsed_num != msg_num)
+			++bad_num;
+	}
+
+	auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+	printf("%-32s %.1f million messages per second, %.1f reads per 1000 messages%s\n", name, msg_num * round_num / duration / 1000000,
+		1000. * read_num / round_num / msg_num, bad_num > 0 ? ", UNPACKING FAILED!" : "");
+}
+
+int main(int argc, const char* argv[])
+{
+	size_t msg_num = argc > 1 ? (size_t) atoi(argv[1]) : 1000000;
+	int round_num = argc > 2 ? atoi(argv[2]) : 10;
+	if (0 == msg_num || round_num < 1)
+	{
+		puts("usage: unpacker_benchmark [<message number (> 0)> [<round number (> 0)>]]");
+		return 1;
+	}
+
+	//mixed sizes: mostly small messages, some medium ones and a few big ones (close to the buffer size)
+	packer<> packer_;
+	std::string stream;
+	std::mt19937 gen;
+	for (size_t i = 0; i < msg_num; ++i)
+	{
+		auto kind = gen() % 100;
+		auto size = kind < 70 ? 8 + gen() % 120 : kind < 95 ? 128 + gen() % 1024 : 1152 + gen() % (ASCS_MSG_BUFFER_SIZE - ASCS_HEAD_LEN - 1152);
+		stream += packer_.pack_msg(std::string(size, '0'));
+	}
+
+	printf(ASCS_SF " messages (" ASCS_SF " bytes), %d rounds, scattered recv buffer: %s.\n", msg_num, stream.size(), round_num,
+#ifdef ASCS_SCATTERED_RECV_BUFFER
+		"yes"
+#else
+		"no"
+#endif
+	);
+	benchmark<memmove_unpacker>("memmove:", stream, msg_num, round_num);
+#ifdef ASCS_SCATTERED_RECV_BUFFER
+	benchmark<unpacker<>>("ring buffer:", stream, msg_num, round_num);
+#else
+	benchmark<unpacker<>>("default (memmove):", stream, msg_num, round_num);
+#endif
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+
+#include <iostream>
+#include <sys/resource.h>
+
+//configuration
+#define ASCS_SERVER_PORT	9529
+#define ASCS_HUGE_MSG
+#define ASCS_MSG_BUFFER_SIZE	(1024 * 1024)
+#define ASCS_ZEROCOPY_SEND //comment this to send messages as usual, then compare
+//configuration
+
+#include <ascs/ext/tcp.h>
+using namespace ascs;
+using namespace ascs::ext::tcp;
+
+//measure the CPU cost of sending big messages, with macro ASCS_ZEROCOPY_SEND, the kernel sends from messages directly (MSG_ZEROCOPY)
+// rather than copying them, so the system time of the sender drops.
+//on loopback (and some devices), the kernel copies messages anyway, then ascs gives up zero-copy after the first notification, so you will
+// see no differences, run the server and the client on two hosts instead.
+//usage: zerocopy_benchmark server [<port>]
+//       zerocopy_benchmark client <server ip> [<port> [<message size (KB)=64> [<total size (MB)=4096>]]]
+//       zerocopy_benchmark (run both the server and the client on loopback)
+
+std::atomic_uint_fast64_t recv_byte_num(0);
+
+class sink_socket : public server_socket
+{
+public:
+	sink_socket(ascs::tcp::i_server& server_) : server_socket(server_) {}
+
+protected:
+	virtual bool on_msg_handle(out_msg_type& msg) {recv_byte_num += msg.size(); return true;}
+};
+
+static double cpu_time(const timeval& tv) {return tv.tv_sec + tv.tv_usec / 1000000.;}
+
+static void run_client(service_pump& sp, const std::string& ip, unsigned short port, size_t msg_size, size_t total_size)
+{
+	single_client client(sp);
+	client.set_server_addr(port, ip);
+	sp.start_service();
+	while (!client.is_connected())
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	rusage begin_usage, end_usage;
+	getrusage(RUSAGE_SELF, &begin_usage);
+	auto begin_time = std::chrono::steady_clock::now();
+
+	std::string msg(msg_size, '0');
+	auto msg_num = total_size / msg_size;
+	for (size_t i = 0; i < msg_num; ++i)
+		while (!client.send_msg(msg))
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	while (client.get_statistic().send_msg_sum < msg_num)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+	getrusage(RUSAGE_SELF, &end_usage);
+
+	printf("zero-copy: %s, sent " ASCS_SF " messages of " ASCS_SF " KB in %.2f seconds (%.1f MB/s), user time: %.2f s, system time: %.2f s.\n",
+#ifdef ASCS_ZEROCOPY_SEND
+		"on",
+#else
+		"off",
+#endif
+		msg_num, msg_size / 1024, duration, msg_num * msg_size / 1024. / 1024. / duration,
+		cpu_time(end_usage.ru_utime) - cpu_time(begin_usage.ru_utime), cpu_time(end_usage.ru_stime) - cpu_time(begin_usage.ru_stime));
+	sp.stop_service();
+}
+
+int main(int argc, const char* argv[])
+{
+	service_pump sp;
+	if (argc > 1 && 0 == strcmp(argv[1], "server"))
+	{
+		ascs::tcp::server_base<sink_socket> server_(sp);
+		server_.set_server_addr(argc > 2 ? (unsigned short) atoi(argv[2]) : ASCS_SERVER_PORT);
+		sp.start_service();
+		while (sp.is_running())
+		{
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			printf("received " ASCS_LLF " MB\n", (uint_fast64_t) recv_byte_num / 1024 / 1024);
+		}
+
+		return 0;
+	}
+	else if (argc > 1 && (0 != strcmp(argv[1], "client") || argc < 3))
+	{
+		puts("usage: zerocopy_benchmark server [<port>]\n"
+			"       zerocopy_benchmark client <server ip> [<port> [<message size (KB)> [<total size (MB)>]]]\n"
+			"       zerocopy_benchmark");
+		return 1;
+	}
+
+	auto port = argc > 3 ? (unsigned short) atoi(argv[3]) : (unsigned short) ASCS_SERVER_PORT;
+	auto msg_size = (argc > 4 ? (size_t) atoi(argv[4]) : 64) * 1024;
+	auto total_size = (argc > 5 ? (size_t) atoi(argv[5]) : 4096) * 1024 * 1024;
+	if (0 == msg_size || msg_size > ASCS_MSG_BUFFER_SIZE - ASCS_HEAD_LEN || total_size < msg_size)
+	{
+		printf("message size must be within (0, " ASCS_SF "] bytes and not bigger than the total size.\n", (size_t) (ASCS_MSG_BUFFER_SIZE - ASCS_HEAD_LEN));
+		return 1;
+	}
+
+	if (argc > 2)
+		run_client(sp, argv[2], port, msg_size, total_size);
+	else //loopback
+	{
+		ascs::tcp::server_base<sink_socket> server_(sp);
+		run_client(sp, "127.0.0.1", port, msg_size, total_size);
+	}
+
+	return 0;
+}
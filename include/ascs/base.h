@@ -26,11 +26,19 @@
 #include <atomic>
 #include <sstream>
 #include <iomanip>
-#ifdef ASCS_SYNC_SEND
-#include <future>
-#elif defined(ASCS_SYNC_RECV)
+#if defined(ASCS_SYNC_SEND) || defined(ASCS_SYNC_RECV)
 #include <condition_variable>
 #endif
+#if defined(ASCS_HUGE_PAGE_ARENA) || defined(ASCS_CONFLATE_SEND_MSG)
+#include <unordered_map>
+#endif
+#ifdef ASCS_HUGE_PAGE_ARENA
+#ifdef __linux__
+#include <sys/mman.h>
+#else
+#include <boost/align/aligned_alloc.hpp>
+#endif
+#endif
 
 #include <boost/asio.hpp>
 #include <boost/version.hpp>
@@ -161,6 +169,9 @@ public:
 	virtual bool pack_msg(msg_type&& msg1, msg_type&& msg2, container_type& msg_can) {return false;}
 	virtual bool pack_msg(container_type& in, container_type& out) {return false;}
 	virtual msg_type pack_heartbeat() {return msg_type();}
+	//pack a message and append it to the end of slab (a message which holds several packed messages), return false if not supported,
+	// then the caller will fall back to pack_msg. it's used by macro ASCS_COALESCE_SEND_MSG.
+	virtual bool append_msg(msg_type& slab, const char* const pstr[], const size_t len[], size_t num, bool native = false) {return false;}
 
 	//this default implementation is meaningless, just satisfy compilers
 	virtual char* raw_data(msg_type& msg) const {return const_cast<char*>(msg.data());}
@@ -328,6 +339,22 @@ struct statistic
 	{
 		send_msg_sum = 0;
 		send_byte_sum = 0;
+#ifdef ASCS_EXPIRE_SEND_MSG
+		send_expired_msg_sum = 0;
+#endif
+#ifdef ASCS_CONFLATE_SEND_MSG
+		send_conflated_msg_sum = 0;
+#endif
+#ifdef ASCS_SPILL_SEND_BUFFER
+		send_spilled_msg_sum = 0;
+#endif
+#ifdef ASCS_COALESCE_SEND_MSG
+		send_coalesced_msg_sum = 0;
+#endif
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+		lagging_sum = 0;
+		stuck_sum = 0;
+#endif
 
 		recv_msg_sum = 0;
 		recv_byte_sum = 0;
@@ -360,6 +387,22 @@ struct statistic
 	{
 		send_msg_sum += other.send_msg_sum;
 		send_byte_sum += other.send_byte_sum;
+#ifdef ASCS_EXPIRE_SEND_MSG
+		send_expired_msg_sum += other.send_expired_msg_sum;
+#endif
+#ifdef ASCS_CONFLATE_SEND_MSG
+		send_conflated_msg_sum += other.send_conflated_msg_sum;
+#endif
+#ifdef ASCS_SPILL_SEND_BUFFER
+		send_spilled_msg_sum += other.send_spilled_msg_sum;
+#endif
+#ifdef ASCS_COALESCE_SEND_MSG
+		send_coalesced_msg_sum += other.send_coalesced_msg_sum;
+#endif
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+		lagging_sum += other.lagging_sum;
+		stuck_sum += other.stuck_sum;
+#endif
 		send_delay_sum += other.send_delay_sum;
 		send_time_sum += other.send_time_sum;
 		pack_time_sum += other.pack_time_sum;
@@ -386,6 +429,22 @@ struct statistic
 	{
 		send_msg_sum -= other.send_msg_sum;
 		send_byte_sum -= other.send_byte_sum;
+#ifdef ASCS_EXPIRE_SEND_MSG
+		send_expired_msg_sum -= other.send_expired_msg_sum;
+#endif
+#ifdef ASCS_CONFLATE_SEND_MSG
+		send_conflated_msg_sum -= other.send_conflated_msg_sum;
+#endif
+#ifdef ASCS_SPILL_SEND_BUFFER
+		send_spilled_msg_sum -= other.send_spilled_msg_sum;
+#endif
+#ifdef ASCS_COALESCE_SEND_MSG
+		send_coalesced_msg_sum -= other.send_coalesced_msg_sum;
+#endif
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+		lagging_sum -= other.lagging_sum;
+		stuck_sum -= other.stuck_sum;
+#endif
 		send_delay_sum -= other.send_delay_sum;
 		send_time_sum -= other.send_time_sum;
 		pack_time_sum -= other.pack_time_sum;
@@ -412,6 +471,21 @@ struct statistic
 	{
 		std::ostringstream s;
 		s << "send relevant statistic:\nmessage sum: " << send_msg_sum << std::endl << "size in bytes: " << send_byte_sum << std::endl
+#ifdef ASCS_EXPIRE_SEND_MSG
+			<< "expired message sum: " << send_expired_msg_sum << std::endl
+#endif
+#ifdef ASCS_CONFLATE_SEND_MSG
+			<< "conflated message sum: " << send_conflated_msg_sum << std::endl
+#endif
+#ifdef ASCS_SPILL_SEND_BUFFER
+			<< "spilled message sum: " << send_spilled_msg_sum << std::endl
+#endif
+#ifdef ASCS_COALESCE_SEND_MSG
+			<< "coalesced message sum: " << send_coalesced_msg_sum << std::endl
+#endif
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+			<< "lagging times: " << lagging_sum << std::endl << "stuck times: " << stuck_sum << std::endl
+#endif
 #ifdef ASCS_FULL_STATISTIC
 			<< "send delay: " << send_delay_sum << std::endl << "send duration: " << send_time_sum << std::endl << "pack duration: " << pack_time_sum << std::endl
 #endif
@@ -423,20 +497,28 @@ struct statistic
 		;return s.str();
 	}
 
+	//items are ordered by their writers, the IO strand, threads which send messages and the dispatch strand, groups can be separated by
+	// cache line paddings (opt-in), see macro ASCS_CACHE_LINE_SIZE.
+
+	//written by the IO strand
 	//send relevant statistic
 	uint_fast64_t send_msg_sum{0}; //msgs in sending buffer are not counted
 	uint_fast64_t send_byte_sum{0}; //include data added by packer, msgs in sending buffer are not counted
+#ifdef ASCS_EXPIRE_SEND_MSG
+	uint_fast64_t send_expired_msg_sum{0}; //msgs dropped because of expiry, see macro ASCS_EXPIRE_SEND_MSG
+#endif
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	uint_fast64_t lagging_sum{0}; //how many times the peer became a lagging consumer, see macro ASCS_SLOW_CONSUMER_CHECK
+	uint_fast64_t stuck_sum{0}; //how many times the peer became a stuck consumer
+#endif
 	stat_duration send_delay_sum; //from send_(native_)msg (exclude msg packing) to boost::asio::async_write
 	stat_duration send_time_sum; //from boost::asio::async_write to send_handler
 	//above two items indicate your network's speed or load
-	stat_duration pack_time_sum; //udp::socket_base will not gather this item
 
 	//recv relevant statistic
 	uint_fast64_t recv_msg_sum{0}; //msgs returned by i_unpacker::parse_msg
 	uint_fast64_t recv_byte_sum{0}; //msgs (in bytes) returned by i_unpacker::parse_msg
-	stat_duration dispatch_delay_sum; //from parse_msg(exclude msg unpacking) to on_msg_handle
 	stat_duration recv_idle_sum; //during this duration, socket suspended msg reception (receiving buffer overflow)
-	stat_duration handle_time_sum; //on_msg_handle (and on_msg) consumed time, this indicate the performance of msg handling
 	stat_duration unpack_time_sum; //udp::socket_base will not gather this item
 
 	time_t establish_time{0}; //time of link establishment
@@ -444,6 +526,28 @@ struct statistic
 
 	time_t last_send_time{0}; //include heartbeat
 	time_t last_recv_time{0}; //include heartbeat
+
+	//written by threads which send messages
+#if defined(ASCS_FULL_STATISTIC) || defined(ASCS_CONFLATE_SEND_MSG) || defined(ASCS_SPILL_SEND_BUFFER) || defined(ASCS_COALESCE_SEND_MSG)
+	ASCS_CACHE_LINE_PADDING(producer_padding)
+#endif
+	stat_duration pack_time_sum; //udp::socket_base will not gather this item
+#ifdef ASCS_CONFLATE_SEND_MSG
+	uint_fast64_t send_conflated_msg_sum{0}; //msgs replaced by newer ones with the same key, see macro ASCS_CONFLATE_SEND_MSG
+#endif
+#ifdef ASCS_SPILL_SEND_BUFFER
+	uint_fast64_t send_spilled_msg_sum{0}; //msgs spilled to disk because of overflow, see macro ASCS_SPILL_SEND_BUFFER
+#endif
+#ifdef ASCS_COALESCE_SEND_MSG
+	uint_fast64_t send_coalesced_msg_sum{0}; //msgs packed into send slabs, see macro ASCS_COALESCE_SEND_MSG
+#endif
+
+	//written by the dispatch strand
+#ifdef ASCS_FULL_STATISTIC
+	ASCS_CACHE_LINE_PADDING(dispatch_padding)
+#endif
+	stat_duration dispatch_delay_sum; //from parse_msg(exclude msg unpacking) to on_msg_handle
+	stat_duration handle_time_sum; //on_msg_handle (and on_msg) consumed time, this indicate the performance of msg handling
 };
 
 class auto_duration
@@ -461,30 +565,269 @@ private:
 };
 
 enum sync_call_result {SUCCESS, NOT_APPLICABLE, DUPLICATE, TIMEOUT};
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+enum consumer_state {HEALTHY, LAGGING, STUCK}; //see macro ASCS_SLOW_CONSUMER_CHECK
+#endif
 
 template<typename T> struct obj_with_begin_time : public T
 {
 	obj_with_begin_time() {}
-	obj_with_begin_time(const T& obj) : T(obj) {restart();}
-	obj_with_begin_time(T&& obj) : T(std::move(obj)) {restart();}
-	obj_with_begin_time& operator=(const T& obj) {T::operator=(obj); restart(); return *this;}
-	obj_with_begin_time& operator=(T&& obj) {T::operator=(std::move(obj)); restart(); return *this;}
+	obj_with_begin_time(const T& obj) : T(obj) {restart(); requeue();}
+	obj_with_begin_time(T&& obj) : T(std::move(obj)) {restart(); requeue();}
+	obj_with_begin_time& operator=(const T& obj) {T::operator=(obj); restart(); requeue(); return *this;}
+	obj_with_begin_time& operator=(T&& obj) {T::operator=(std::move(obj)); restart(); requeue(); return *this;}
+#ifdef ASCS_EXPIRE_SEND_MSG
+	obj_with_begin_time(const obj_with_begin_time& other) : T(other), begin_time(other.begin_time), queued_time(other.queued_time), batch_id(other.batch_id) {}
+	obj_with_begin_time(obj_with_begin_time&& other) :
+		T(std::move(other)), begin_time(std::move(other.begin_time)), queued_time(other.queued_time), batch_id(other.batch_id) {}
+	obj_with_begin_time& operator=(const obj_with_begin_time& other)
+		{T::operator=(other); begin_time = other.begin_time; queued_time = other.queued_time; batch_id = other.batch_id; return *this;}
+	obj_with_begin_time& operator=(obj_with_begin_time&& other)
+		{T::operator=(std::move(other)); begin_time = std::move(other.begin_time); queued_time = other.queued_time; batch_id = other.batch_id; return *this;}
+#else
 	obj_with_begin_time(const obj_with_begin_time& other) : T(other), begin_time(other.begin_time) {}
 	obj_with_begin_time(obj_with_begin_time&& other) : T(std::move(other)), begin_time(std::move(other.begin_time)) {}
 	obj_with_begin_time& operator=(const obj_with_begin_time& other) {T::operator=(other); begin_time = other.begin_time; return *this;}
 	obj_with_begin_time& operator=(obj_with_begin_time&& other) {T::operator=(std::move(other)); begin_time = std::move(other.begin_time); return *this;}
+#endif
 
 	void restart() {restart(statistic::now());}
 	void restart(const typename statistic::stat_time& begin_time_) {begin_time = begin_time_;}
-	void swap(T& obj) {T::swap(obj); restart();}
+	void swap(T& obj) {T::swap(obj); restart(); requeue();}
+#ifdef ASCS_EXPIRE_SEND_MSG
+	void swap(obj_with_begin_time& other)
+		{T::swap(other); std::swap(begin_time, other.begin_time); std::swap(queued_time, other.queued_time); std::swap(batch_id, other.batch_id);}
+#else
 	void swap(obj_with_begin_time& other) {T::swap(other); std::swap(begin_time, other.begin_time);}
+#endif
 
 	void clear() {T::clear(); begin_time = typename statistic::stat_time();}
 
 	typename statistic::stat_time begin_time;
+#ifdef ASCS_EXPIRE_SEND_MSG
+	void requeue() {queued_time = std::chrono::steady_clock::now(); batch_id = 0;}
+	std::chrono::steady_clock::time_point queued_time; //when the message entered the send buffer, see macro ASCS_EXPIRE_SEND_MSG
+	uint_fast64_t batch_id{0}; //messages queued together (see socket::unify_queued_time) share the same non-zero id and expire together
+#else
+	void requeue() {}
+#endif
+};
+
+//a type-erased callable like std::function, but it also accepts move-only callables (for example, tracked_handler), so it's move-only itself.
+template<typename Signature> class move_only_function;
+template<typename R, typename... Args> class move_only_function<R(Args...)>
+{
+public:
+	move_only_function() {}
+	move_only_function(std::nullptr_t) {}
+	template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, move_only_function>::value>::type>
+	move_only_function(F&& f) : callable(new holder<typename std::decay<F>::type>(std::forward<F>(f))) {}
+	move_only_function(move_only_function&& other) : callable(std::move(other.callable)) {}
+
+	move_only_function& operator=(move_only_function&& other) {callable = std::move(other.callable); return *this;}
+	move_only_function& operator=(std::nullptr_t) {callable.reset(); return *this;}
+
+	void swap(move_only_function& other) {callable.swap(other.callable);}
+	explicit operator bool() const {return !!callable;}
+	R operator()(Args... args) const {assert(callable); return callable->call(std::forward<Args>(args)...);}
+
+private:
+	struct i_holder
+	{
+		virtual ~i_holder() {}
+		virtual R call(Args&&... args) = 0;
+	};
+
+	template<typename F> struct holder : public i_holder
+	{
+		template<typename T> holder(T&& f_) : f(std::forward<T>(f_)) {}
+		virtual R call(Args&&... args) {return f(std::forward<Args>(args)...);}
+
+		F f;
+	};
+
+	std::unique_ptr<i_holder> callable;
+};
+
+//a view of contiguous objects (like std::span in c++20), it doesn't own the objects.
+template<typename T> class obj_span
+{
+public:
+	typedef T value_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	obj_span() {}
+	obj_span(T* data_, size_t size_) : _data(data_), _size(size_) {}
+
+	T* data() const {return _data;}
+	size_t size() const {return _size;}
+	bool empty() const {return 0 == _size;}
+
+	T& operator[](size_t index) const {assert(index < _size); return _data[index];}
+	T& front() const {assert(_size > 0); return *_data;}
+	T& back() const {assert(_size > 0); return _data[_size - 1];}
+	T* begin() const {return _data;}
+	T* end() const {return _data + _size;}
+
+private:
+	T* _data{nullptr};
+	size_t _size{0};
 };
 
 #ifdef ASCS_SYNC_SEND
+class sync_send_slot_pool;
+class sync_send_slot_ptr;
+
+//completion slot of sync message sending, it replaces std::promise and std::future, slots are recycled by a per-socket pool (see
+// sync_send_slot_pool), so no allocation after warming up, and if the sending completed before the waiter goes to sleep, neither the mutex nor
+// the condition_variable will be touched.
+//if all messages refer to a slot have been released without setting a result (like a broken promise), the result will be NOT_APPLICABLE.
+class sync_send_slot : public boost::noncopyable
+{
+public:
+	//only the first result takes effect
+	void set_value(sync_call_result re)
+	{
+		if (READY == status.load(std::memory_order_acquire))
+			return;
+
+		result = re;
+		if (WAITING == status.exchange(READY, std::memory_order_acq_rel))
+		{
+			std::lock_guard<std::mutex> lock(mutex); //the waiter either has not checked the status yet or is waiting on cv
+			cv.notify_one();
+		}
+	}
+
+	//unit of the duration is millisecond, 0 means wait infinitely
+	sync_call_result wait(unsigned duration)
+	{
+		auto pred = [this]() {return READY == status.load(std::memory_order_acquire);};
+		for (auto i = 0; i < 16; ++i) //the sending of a small message completes quickly, give it a chance before going to sleep
+			if (pred())
+				return result;
+			else
+				std::this_thread::yield();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		auto expected = (int) IDLE;
+		if (status.compare_exchange_strong(expected, WAITING, std::memory_order_acq_rel))
+		{
+			if (0 == duration)
+				cv.wait(lock, pred);
+			else if (!cv.wait_for(lock, std::chrono::milliseconds(duration), pred))
+				return sync_call_result::TIMEOUT;
+		}
+
+		return result;
+	}
+
+private:
+	friend class sync_send_slot_pool;
+	friend class sync_send_slot_ptr;
+
+	sync_send_slot() {}
+
+	void init() {status.store(IDLE, std::memory_order_relaxed); ref.store(1, std::memory_order_relaxed); msg_ref.store(1, std::memory_order_relaxed);}
+	void add_ref(bool waiter) {if (!waiter) msg_ref.fetch_add(1, std::memory_order_relaxed); ref.fetch_add(1, std::memory_order_relaxed);}
+	inline void release(bool waiter);
+
+private:
+	enum {IDLE, WAITING, READY};
+	std::atomic_int status{IDLE};
+	sync_call_result result{sync_call_result::NOT_APPLICABLE};
+
+	std::atomic_uint ref{0}, msg_ref{0}; //ref includes waiters and messages
+	std::shared_ptr<sync_send_slot_pool> pool; //keep the pool alive while this slot is in use, even if the socket has been freed
+
+	std::mutex mutex;
+	std::condition_variable cv;
+};
+
+//messages and waiters refer to a slot via this smart pointer, messages copied from each other share the same slot.
+class sync_send_slot_ptr
+{
+public:
+	sync_send_slot_ptr() {}
+	sync_send_slot_ptr(const sync_send_slot_ptr& other) : slot(other.slot), waiter(other.waiter) {if (nullptr != slot) slot->add_ref(waiter);}
+	sync_send_slot_ptr(sync_send_slot_ptr&& other) : slot(other.slot), waiter(other.waiter) {other.slot = nullptr;}
+	~sync_send_slot_ptr() {reset();}
+
+	sync_send_slot_ptr& operator=(sync_send_slot_ptr other) {swap(other); return *this;}
+
+	explicit operator bool() const {return nullptr != slot;}
+	sync_send_slot* operator->() const {return slot;}
+	sync_send_slot* get() const {return slot;}
+
+	void swap(sync_send_slot_ptr& other) {std::swap(slot, other.slot); std::swap(waiter, other.waiter);}
+	void reset() {if (nullptr != slot) {slot->release(waiter); slot = nullptr;}}
+
+	//a waiter doesn't prevent the slot from being broken
+	sync_send_slot_ptr get_waiter() const {sync_send_slot_ptr re; if (nullptr != slot) {re.slot = slot; re.waiter = true; slot->add_ref(true);} return re;}
+
+	static sync_send_slot_ptr create() {return sync_send_slot_ptr(new sync_send_slot());} //not pooled
+
+private:
+	friend class sync_send_slot_pool;
+	sync_send_slot_ptr(sync_send_slot* slot_) : slot(slot_) {slot->init();}
+
+private:
+	sync_send_slot* slot{nullptr};
+	bool waiter{false};
+};
+
+class sync_send_slot_pool : public std::enable_shared_from_this<sync_send_slot_pool>, public boost::noncopyable
+{
+public:
+	~sync_send_slot_pool() {for (auto item : free_slots) delete item;}
+
+	sync_send_slot_ptr acquire()
+	{
+		sync_send_slot* slot = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!free_slots.empty())
+			{
+				slot = free_slots.back();
+				free_slots.pop_back();
+			}
+		}
+
+		if (nullptr == slot)
+			slot = new sync_send_slot();
+		slot->pool = shared_from_this();
+
+		return sync_send_slot_ptr(slot);
+	}
+
+private:
+	friend class sync_send_slot;
+	void recycle(sync_send_slot* slot) {std::lock_guard<std::mutex> lock(mutex); free_slots.push_back(slot);}
+
+private:
+	std::mutex mutex;
+	std::vector<sync_send_slot*> free_slots;
+};
+
+void sync_send_slot::release(bool waiter)
+{
+	if (!waiter && 1 == msg_ref.fetch_sub(1, std::memory_order_acq_rel))
+		set_value(sync_call_result::NOT_APPLICABLE); //broken, if a result has been set, this is a no-op
+	if (1 == ref.fetch_sub(1, std::memory_order_acq_rel))
+	{
+		if (!pool)
+			delete this;
+		else
+		{
+			auto owner = std::move(pool); //the pool can be freed after recycling, but not during it
+			owner->recycle(this);
+		}
+	}
+}
+
 template<typename T> struct obj_with_begin_time_promise : public obj_with_begin_time<T>
 {
 	typedef obj_with_begin_time<T> super;
@@ -501,9 +844,9 @@ template<typename T> struct obj_with_begin_time_promise : public obj_with_begin_
 	void swap(obj_with_begin_time_promise& other) {super::swap(other); p.swap(other.p);}
 
 	void clear() {super::clear(); p.reset();}
-	void check_and_create_promise(bool need_promise) {if (!need_promise) p.reset(); else if (!p) p = std::make_shared<std::promise<sync_call_result>>();}
+	void check_and_create_promise(bool need_promise) {if (!need_promise) p.reset(); else if (!p) p = sync_send_slot_ptr::create();}
 
-	std::shared_ptr<std::promise<sync_call_result>> p;
+	sync_send_slot_ptr p;
 };
 #endif
 
@@ -566,6 +909,7 @@ template<typename _Predicate> void NAME(const _Predicate& __pred) const {for (au
 #define SAFE_SEND_MSG_CHECK(F_VALUE) \
 { \
 	if (!is_ready()) return F_VALUE; \
+	this->flush_deferred_sending(); \
 	std::this_thread::sleep_for(std::chrono::milliseconds(50)); \
 }
 
@@ -585,6 +929,12 @@ TYPE FUNNAME(char* pstr, size_t len, bool can_overflow = false, bool prior = fal
 template<typename Buffer> \
 TYPE FUNNAME(const Buffer& buffer, bool can_overflow = false, bool prior = false) {return FUNNAME(buffer.data(), buffer.size(), can_overflow, prior);}
 
+//with macro ASCS_COALESCE_SEND_MSG, small messages will be packed into the slab directly (see socket::coalesce_send_msg).
+#ifdef ASCS_COALESCE_SEND_MSG
+#define TCP_COALESCE_SEND_MSG(NATIVE) else if (!prior && this->coalesce_send_msg(pstr, len, num, NATIVE)) return true;
+#else
+#define TCP_COALESCE_SEND_MSG(NATIVE)
+#endif
 #define TCP_SEND_MSG(FUNNAME, NATIVE) \
 bool FUNNAME(in_msg_type&& msg, bool can_overflow = false, bool prior = false) \
 { \
@@ -656,6 +1006,7 @@ bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return false; \
+	TCP_COALESCE_SEND_MSG(NATIVE) \
 	auto_duration dur(stat.pack_time_sum); \
 	auto msg = this->packer()->pack_msg(pstr, len, num, NATIVE); \
 	dur.end(); \
@@ -680,13 +1031,19 @@ bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_
 	{while (!SEND_FUNNAME(pstr, len, num, can_overflow, prior)) SAFE_SEND_MSG_CHECK(false) return true;} \
 TCP_SEND_MSG_CALL_SWITCH(FUNNAME, bool)
 
+//with macro ASCS_SLOW_CONSUMER_CHECK, stuck consumers will be skipped, otherwise, a stuck consumer can block safe broadcasting forever.
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+#define BROADCAST_FILTER(item) if (consumer_state::STUCK != item->get_consumer_state())
+#else
+#define BROADCAST_FILTER(item)
+#endif
 #define TCP_BROADCAST_MSG(FUNNAME, SEND_FUNNAME) \
 void FUNNAME(typename Pool::in_msg_ctype& msg, bool can_overflow = false, bool prior = false) \
-	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(msg, can_overflow, prior);});} \
+	{this->do_something_to_all([&](typename Pool::object_ctype& item) {BROADCAST_FILTER(item) item->SEND_FUNNAME(msg, can_overflow, prior);});} \
 void FUNNAME(typename Pool::in_msg_ctype& msg1, typename Pool::in_msg_ctype& msg2, bool can_overflow = false, bool prior = false) \
-	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(msg1, msg2, can_overflow, prior);});} \
+	{this->do_something_to_all([&](typename Pool::object_ctype& item) {BROADCAST_FILTER(item) item->SEND_FUNNAME(msg1, msg2, can_overflow, prior);});} \
 void FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_overflow = false, bool prior = false) \
-	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(pstr, len, num, can_overflow, prior);});} \
+	{this->do_something_to_all([&](typename Pool::object_ctype& item) {BROADCAST_FILTER(item) item->SEND_FUNNAME(pstr, len, num, can_overflow, prior);});} \
 TCP_SEND_MSG_CALL_SWITCH(FUNNAME, void)
 //TCP msg sending interface
 ///////////////////////////////////////////////////
@@ -958,6 +1315,169 @@ public:
 };
 #endif
 
+#ifdef ASCS_HUGE_PAGE_ARENA
+//a process wide memory arena whose memory comes from huge pages (explicit hugetlbfs pages first, then transparent huge pages, then normal memory),
+//memory is carved (ASCS_HUGE_PAGE_ARENA_ALIGNMENT aligned) from chunks of ASCS_HUGE_PAGE_SIZE bytes, freed memory will be kept in free lists
+// (one for each size) for reusing, and will never be returned to the operating system, please note.
+class huge_page_arena : public boost::noncopyable
+{
+public:
+	//leaked on purpose, objects allocated from the arena can outlive any static object (and be freed during the exit)
+	static huge_page_arena& instance() {static auto arena = new huge_page_arena; return *arena;}
+
+	void* allocate(size_t size)
+	{
+		size = round_up(size, ASCS_HUGE_PAGE_ARENA_ALIGNMENT);
+		if (size > ASCS_HUGE_PAGE_SIZE / 2) //big blocks occupy their own chunks
+		{
+			auto p = alloc_chunk(round_up(size, ASCS_HUGE_PAGE_SIZE));
+			if (nullptr == p)
+				throw std::bad_alloc();
+
+			return p;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto& free_can = free_cans[size];
+		if (!free_can.empty())
+		{
+			auto p = free_can.back();
+			free_can.pop_back();
+			return p;
+		}
+
+		if (size > remain_len)
+		{
+			auto p = (char*) alloc_chunk(ASCS_HUGE_PAGE_SIZE);
+			if (nullptr == p)
+				throw std::bad_alloc();
+
+			//the tail of the old chunk is wasted
+			cur_pos = p;
+			remain_len = ASCS_HUGE_PAGE_SIZE;
+		}
+
+		auto p = cur_pos;
+		cur_pos += size;
+		remain_len -= size;
+
+		return p;
+	}
+
+	void deallocate(void* p, size_t size)
+	{
+		if (nullptr == p)
+			return;
+
+		size = round_up(size, ASCS_HUGE_PAGE_ARENA_ALIGNMENT);
+		if (size > ASCS_HUGE_PAGE_SIZE / 2)
+			free_chunk(p, round_up(size, ASCS_HUGE_PAGE_SIZE));
+		else
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			free_cans[size].emplace_back(p);
+		}
+	}
+
+	//how many chunks been backed by explicit and transparent huge pages respectively, and how many chunks fell back to normal memory.
+	void get_statistic(size_t& explicit_num, size_t& transparent_num, size_t& normal_num) const
+		{explicit_num = explicit_chunk_num; transparent_num = transparent_chunk_num; normal_num = normal_chunk_num;}
+
+private:
+	huge_page_arena() {}
+
+	static size_t round_up(size_t size, size_t alignment) {return 0 == size ? alignment : (size + alignment - 1) / alignment * alignment;}
+
+	void* alloc_chunk(size_t size)
+	{
+#ifdef __linux__
+#ifdef MAP_HUGETLB
+		if (!no_explicit_huge_page)
+		{
+			auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (MAP_FAILED != p)
+			{
+				++explicit_chunk_num;
+				return p;
+			}
+
+			//no (or not enough) huge pages reserved in hugetlbfs, don't try again, get_statistic tells this
+			no_explicit_huge_page = true;
+		}
+#endif
+		//over allocate to align the chunk on a huge page boundary, transparent huge pages can only be used on aligned addresses
+		auto p = mmap(nullptr, size + ASCS_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (MAP_FAILED == p)
+			return nullptr;
+
+		auto begin = (char*) p;
+		auto aligned_begin = (char*) round_up((size_t) begin, ASCS_HUGE_PAGE_SIZE);
+		if (aligned_begin > begin)
+			munmap(begin, aligned_begin - begin);
+		munmap(aligned_begin + size, ASCS_HUGE_PAGE_SIZE - (aligned_begin - begin));
+
+#ifdef MADV_HUGEPAGE
+		if (0 == madvise(aligned_begin, size, MADV_HUGEPAGE))
+		{
+			++transparent_chunk_num;
+			return aligned_begin;
+		}
+#endif
+		++normal_chunk_num;
+		return aligned_begin;
+#else
+		++normal_chunk_num;
+		return boost::alignment::aligned_alloc(ASCS_HUGE_PAGE_ARENA_ALIGNMENT, size);
+#endif
+	}
+
+	void free_chunk(void* p, size_t size)
+	{
+#ifdef __linux__
+		munmap(p, size);
+#else
+		boost::alignment::aligned_free(p);
+#endif
+	}
+
+private:
+	char* cur_pos{nullptr};
+	size_t remain_len{0};
+	std::unordered_map<size_t, std::vector<void*>> free_cans; //size -> free blocks
+	std::mutex mutex;
+
+	std::atomic_bool no_explicit_huge_page{false};
+	std::atomic_size_t explicit_chunk_num{0}, transparent_chunk_num{0}, normal_chunk_num{0};
+};
+
+//an allocator which allocates memory from huge_page_arena, it can be used with std containers and std::allocate_shared.
+template<typename T> class huge_page_allocator
+{
+public:
+	typedef T value_type;
+
+	huge_page_allocator() {}
+	template<typename U> huge_page_allocator(const huge_page_allocator<U>&) {}
+
+	T* allocate(size_t n) {return (T*) huge_page_arena::instance().allocate(n * sizeof(T));}
+	void deallocate(T* p, size_t n) {huge_page_arena::instance().deallocate(p, n * sizeof(T));}
+
+	template<typename U> bool operator==(const huge_page_allocator<U>&) const {return true;}
+	template<typename U> bool operator!=(const huge_page_allocator<U>&) const {return false;}
+};
+#endif
+
+//create objects that belong to sockets (the sockets themselves, packers and unpackers), with macro ASCS_HUGE_PAGE_ARENA,
+// they will be allocated from huge_page_arena.
+template<typename T, typename... Args> std::shared_ptr<T> make_shared_object(Args&&... args)
+{
+#ifdef ASCS_HUGE_PAGE_ARENA
+	return std::allocate_shared<T>(huge_page_allocator<T>(), std::forward<Args>(args)...);
+#else
+	return std::make_shared<T>(std::forward<Args>(args)...);
+#endif
+}
+
 } //namespace
 
 #endif /* _ASCS_BASE_H_ */
@@ -872,6 +872,59 @@
  *
  * REPLACEMENTS:
  *
+ * ===============================================================
+ * 2026.10.19	version 1.9.0
+ *
+ * SPECIAL ATTENTION (incompatible with old editions):
+ * in_msg::p is not std::shared_ptr<std::promise<sync_call_result>> any more but a sync_send_slot_ptr (pooled completion slot), you can
+ *  still call set_value on it.
+ * Typedef ReadWriteCallBack of tcp and websocket reader_writer has been removed, async_read and async_write are templates now.
+ *
+ * HIGHLIGHT:
+ *
+ * FIX:
+ *
+ * ENHANCEMENTS:
+ * Introduce macro ASCS_CPU_AFFINITY to support binding io_context to specific CPUs and NUMA node, see service_pump::set_io_context_affinity
+ *  and service_pump::prefer_numa_node for more details.
+ * Introduce macro ASCS_HUGE_PAGE_ARENA to allocate sockets, packers and unpackers (include unpackers' buffers) from huge pages.
+ * Introduce macro ASCS_TIMING_WHEEL to make ascs::timer use a hierarchical timing wheel (one for each io_context) instead of one asio timer per timer.
+ * Timers whose id is less than ASCS_TIMER_SLOT_NUM can be found without any locks, and the status of timers became atomic.
+ * Introduce macro ASCS_HEARTBEAT_SCHEDULER to make all sockets in the same io_context share one heartbeat scheduler instead of one timer per socket.
+ * Introduce function socket::stop_heartbeat.
+ * Introduce macro ASCS_DISPATCH_BUDGET_MSG_NUM and ASCS_DISPATCH_BUDGET_DURATION to handle more than one message in one dispatching, see
+ *  socket::dispatch_budget for more details, and macro ASCS_ADAPTIVE_DISPATCH_BUDGET to adjust the budget according to the dispatch delay.
+ * Introduce macro ASCS_DISPATCH_SPAN_MSG, then all messages will be dispatched via on_msg_handle with a contiguous span (see obj_span).
+ * Introduce macro ASCS_CONSOLIDATE_FLUSH to flush the send buffer only once at the end of a handler batch (on_msg or on_msg_handle).
+ * Introduce macro ASCS_NON_HASHED_STRAND to make each socket owns its own strand implementations, see demo strand_benchmark for more details.
+ * With macro ASCS_WANT_MSG_SEND_NOTIFY, tcp still sends messages in batch (gather write), and invokes on_msg_send for each message in the batch.
+ * Introduce sync_recv_msg(msg_can, max_num, min_num, duration) to wait until at least min_num messages been received.
+ * Introduce macro ASCS_EXPIRE_SEND_MSG to drop messages which stayed in the send buffer too long, see socket::send_msg_ttl for more details.
+ * Introduce macro ASCS_SLOW_CONSUMER_CHECK to classify peers as healthy, lagging or stuck consumers, see socket::start_slow_consumer_check.
+ * Introduce macro ASCS_SPILL_SEND_BUFFER to spill overflowed messages to disk (tcp only) rather than refuse them.
+ * Introduce macro ASCS_CONFLATE_SEND_MSG to replace pending messages with newer ones which have the same key, see tcp::socket_base::conflate_send_msg.
+ * Introduce macro ASCS_SEND_STAGING and ASCS_SEND_STAGING_LANE_NUM/ASCS_SEND_STAGING_LANE_SIZE to let concurrent producers of the same socket stage messages in
+ *  per-thread lock-free rings rather than contend on the send buffer.
+ * Introduce macro ASCS_MAX_SEND_IOV and ASCS_SEND_BATCH_DURATION to limit tcp batches by message number too, and adapt the size of batches to the send rate.
+ * Introduce macro ASCS_COALESCE_SEND_MSG to pack small messages into contiguous slabs, see i_packer::append_msg.
+ * Introduce macro ASCS_SEND_LINGER to delay sending for a while (microseconds) to gather fuller batches, see socket::send_linger and socket::flush.
+ * Introduce macro ASCS_ZEROCOPY_SEND to send big messages with MSG_ZEROCOPY on linux (plain tcp only), see ASCS_ZEROCOPY_MIN_SIZE.
+ * Introduce macro ASCS_INLINE_IO to try non-blocking reading and writing in the IO strand before falling back to asynchronous ones.
+ * With macro ASCS_SCATTERED_RECV_BUFFER, the default unpacker uses its buffer as a ring buffer, half-baked msgs will never be moved.
+ *
+ * DELETION:
+ *
+ * REFACTORING:
+ * tracked_executor uses an intrusive counter instead of std::shared_ptr to track asynchronous calls, and wraps handlers with tracked_handler
+ *  (move-only) instead of std::function, so no type erasure for handlers.
+ * reader_writer::async_read and async_write (tcp and websocket) accept any callable (include move-only ones) instead of std::function.
+ * Sync message sending uses pooled completion slots (sync_send_slot) instead of std::promise and std::future.
+ * Sync message receiving doesn't block the IO strand any more (until sync_recv_msg takes the messages), and the receiving path only locks
+ *  the mutex when sync_recv_msg is waiting. sync_recv_msg(msg_can, duration) now waits for at least one message.
+ * Reorder members of ascs::socket, its subclasses and statistic by their writers, paddings between the groups are opt-in, see macro ASCS_CACHE_LINE_SIZE.
+ *
+ * REPLACEMENTS:
+ *
  */
 
 #ifndef _ASCS_CONFIG_H_
@@ -881,8 +934,8 @@
 # pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
-#define ASCS_VER		10800	//[x]xyyzz -> [x]x.[y]y.[z]z
-#define ASCS_VERSION	"1.8.0"
+#define ASCS_VER		10900	//[x]xyyzz -> [x]x.[y]y.[z]z
+#define ASCS_VERSION	"1.9.0"
 
 //boost and compiler check
 #ifdef _MSC_VER
@@ -964,6 +1017,21 @@ static_assert(ASCS_MAX_SEND_BUF > 0, "send buffer capacity must be bigger than z
 #endif
 static_assert(ASCS_MAX_RECV_BUF > 0, "recv buffer capacity must be bigger than zero.");
 
+//tcp sends messages in batch (gather write), one batch contains at most ASCS_MAX_SEND_IOV messages, so it can be sent by one writev (asio
+// sends at most 64 buffers, or IOV_MAX if it's smaller, in one writev, bigger values make asio split the batch), and at most about
+// tcp::reader_writer::batch_msg_send_size bytes, which adapts to the observed send rate of the socket, so that a batch takes about
+// ASCS_SEND_BATCH_DURATION milliseconds to be sent (within [4K, 1M], starts at 64K). partial writes advance within the batch.
+//websocket is not affected by these macros, it always sends one message in one batch.
+#ifndef ASCS_MAX_SEND_IOV
+#define ASCS_MAX_SEND_IOV			64
+#endif
+static_assert(ASCS_MAX_SEND_IOV > 0, "the maximum number of messages in one batch must be bigger than zero.");
+
+#ifndef ASCS_SEND_BATCH_DURATION
+#define ASCS_SEND_BATCH_DURATION	10 //milliseconds
+#endif
+static_assert(ASCS_SEND_BATCH_DURATION > 0, "the expected duration of sending a batch must be bigger than zero.");
+
 //the message mode for websocket, true - binary mode (default), false - text mode
 #ifndef ASCS_WEBSOCKET_BINARY
 #define ASCS_WEBSOCKET_BINARY		true
@@ -983,6 +1051,159 @@ static_assert(ASCS_MAX_RECV_BUF > 0, "recv buffer capacity must be bigger than z
 //    before send_msg returns, so most likely, it will be in your thread, this is unlike other callbacks, which will be called in service threads.
 //#define ASCS_SHRINK_SEND_BUFFER
 
+//#define ASCS_SPILL_SEND_BUFFER
+//for bulk replication links, with this macro, tcp sockets will not refuse messages when the send buffer is insufficient (so safe_send_msg
+// will never block), instead, messages will be spilled to a per-socket temporary file (created via std::tmpfile at the first spilling),
+// and once spilled, all subsequent messages will be spilled too until the spill file been drained, so the order is kept. when the send
+// buffer becomes empty, the IO strand drains the spill file back (at most half of the send buffer each time), so the memory usage keeps
+// bounded while a slow peer catches up, and no message will be lost.
+//please note:
+// 1. messages are restored via the packer (pack_msg with native == true), all packers shipped with ascs support it.
+// 2. prior messages and messages sent by sync_send_msg (series) are never spilled, so they may overtake spilled messages.
+// 3. with macro ASCS_EXPIRE_SEND_MSG, spilled messages get their queued time when they are drained back.
+// 4. udp sockets are not affected by this macro (spilling cannot restore peer addresses).
+// 5. the spill file will not shrink until the socket been freed, but it will be reused from its beginning every time it's drained.
+// 6. if writing the spill file failed, messages will go to the send buffer if nothing has been spilled, otherwise they will be refused (send_msg
+//    returns false) to keep the order.
+//statistic::send_spilled_msg_sum and socket::spilled_send_size_in_byte are provided for monitoring.
+#if defined(ASCS_SPILL_SEND_BUFFER) && defined(ASCS_SHRINK_SEND_BUFFER)
+	#error macro ASCS_SPILL_SEND_BUFFER and ASCS_SHRINK_SEND_BUFFER are exclusive with each other.
+#endif
+
+//#define ASCS_SLOW_CONSUMER_CHECK
+//with this macro, socket::start_slow_consumer_check will be provided, it periodically compares the drain rate (from statistic::send_byte_sum)
+// with the enqueue rate (deduced from the drain rate and the change of the send buffer), and classifies the peer as:
+// healthy, lagging (the send buffer is growing and exceeds ASCS_SLOW_CONSUMER_LAG_USAGE percent of its capacity) or stuck (there're
+// pending messages but no bytes been sent during ASCS_SLOW_CONSUMER_MAX_STUCK continuous intervals).
+//virtual function on_consumer_state_change will be called when the state changed, it's the place of your policy, tcp::server_socket_base
+// disconnects stuck consumers by default. statistic::lagging_sum and stuck_sum record how many times the peer entered each state, and
+// socket::get_consumer_state, drain_rate and enqueue_rate can be used to monitor it.
+//broadcasting (tcp::server_base and tcp::multi_client_base) skips stuck consumers, so they cannot block safe broadcasting.
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	#ifndef ASCS_SLOW_CONSUMER_CHECK_INTERVAL
+	#define ASCS_SLOW_CONSUMER_CHECK_INTERVAL	1000 //milliseconds
+	#endif
+	static_assert(ASCS_SLOW_CONSUMER_CHECK_INTERVAL > 0, "the interval of slow consumer checking must be bigger than zero.");
+
+	#ifndef ASCS_SLOW_CONSUMER_MAX_STUCK
+	#define ASCS_SLOW_CONSUMER_MAX_STUCK	5
+	#endif
+	static_assert(ASCS_SLOW_CONSUMER_MAX_STUCK > 0, "the max stuck times of slow consumers must be bigger than zero.");
+
+	#ifndef ASCS_SLOW_CONSUMER_LAG_USAGE
+	#define ASCS_SLOW_CONSUMER_LAG_USAGE	50 //percent of the send buffer
+	#endif
+	static_assert(ASCS_SLOW_CONSUMER_LAG_USAGE > 0 && ASCS_SLOW_CONSUMER_LAG_USAGE <= 100, "the lag usage must be between 1 and 100.");
+#endif
+
+//#define ASCS_CONFLATE_SEND_MSG
+//for state-update streams (like prices or positions), only the latest value per key matters, with this macro, (direct_)conflate_send_msg
+// (tcp only for the former) will be provided, messages sent by them carry a key and wait in a conflation queue, if a message with the same
+// key is still pending in the queue, it will be replaced in place (counted by statistic::send_conflated_msg_sum when the IO strand takes the
+// newest one), so the depth of the queue is bounded by the number of distinct keys. the IO strand keeps taking messages from the conflation
+// queue into the send buffer (at most one batch is kept in the send buffer), then they cannot be replaced any more.
+//messages sent by conflate_send_msg and send_msg are not ordered with each other.
+
+//#define ASCS_COALESCE_SEND_MSG
+//for streams of small messages, with this macro, tcp send_(native_)msg(pstr, len, ...) packs messages not bigger than ASCS_COALESCE_MSG_SIZE
+// (exclude the header) straight into a per-socket slab (via i_packer::append_msg, ascs::ext::packer and prefix_suffix_packer support it,
+// for other packers, messages will be sent as usual), a slab which reached ASCS_COALESCE_SLAB_SIZE will be put into the send buffer,
+// otherwise, the IO strand takes it when the send buffer holds less than one batch (tcp::reader_writer::batch_msg_send_size), so while the
+// IO strand is busy, small messages keep coalescing, then one batch contains a few big buffers rather than thousands of tiny ones, and no
+// memory allocation per message (slabs are reserved to ASCS_COALESCE_SLAB_SIZE bytes).
+//please note:
+// 1. a slab is just a message in the send buffer, so on_msg_send, on_msg_discard (ASCS_EXPIRE_SEND_MSG) and statistic::send_msg_sum
+//    see slabs rather than the original messages, statistic::send_coalesced_msg_sum records how many messages have been coalesced.
+// 2. prior messages, messages sent by sync_send_msg (series) and other overloads of send_msg (like send_msg(in_msg_type&&)) are not
+//    coalesced, but the order is kept (except prior messages, as usual).
+#ifdef ASCS_COALESCE_SEND_MSG
+	#ifdef ASCS_SEND_STAGING
+		#error macro ASCS_COALESCE_SEND_MSG and ASCS_SEND_STAGING are exclusive with each other.
+	#endif
+
+	#ifndef ASCS_COALESCE_MSG_SIZE
+	#define ASCS_COALESCE_MSG_SIZE	128
+	#endif
+	static_assert(ASCS_COALESCE_MSG_SIZE > 0, "the size of coalescable messages must be bigger than zero.");
+
+	#ifndef ASCS_COALESCE_SLAB_SIZE
+	#define ASCS_COALESCE_SLAB_SIZE	(16 * 1024)
+	#endif
+	static_assert(ASCS_COALESCE_SLAB_SIZE > ASCS_COALESCE_MSG_SIZE, "the size of slabs must be bigger than the size of coalescable messages.");
+#endif
+
+//#define ASCS_SEND_LINGER
+//for throughput-oriented links with trickling traffic, with this macro, socket::send_linger will be provided, if the linger duration
+// (microseconds) is not zero, send_msg (series) will not trigger sending immediately, instead, the first message arms a timer (in the IO
+// strand), and the send buffer will be flushed when the timer expires or the pending messages reach the linger size (bytes), whichever
+// comes first, so trickling messages are sent by fewer and fuller writes, at the price of a bounded delay.
+//while the IO strand is sending, no lingering happens, messages will be sent right after the current batch as usual.
+//socket::flush sends messages immediately regardless of the linger window.
+#ifdef ASCS_SEND_LINGER
+	#ifndef ASCS_SEND_LINGER_DURATION
+	#define ASCS_SEND_LINGER_DURATION	200 //microseconds
+	#endif
+
+	#ifndef ASCS_SEND_LINGER_SIZE
+	#define ASCS_SEND_LINGER_SIZE	(64 * 1024)
+	#endif
+	static_assert(ASCS_SEND_LINGER_SIZE > 0, "the linger size must be bigger than zero.");
+#endif
+
+//#define ASCS_ZEROCOPY_SEND
+//linux only (4.14 or higher), with this macro, tcp::socket_base sets SO_ZEROCOPY on the connection once it's established, and sends batches
+// which contain at least one message not smaller than ASCS_ZEROCOPY_MIN_SIZE bytes with MSG_ZEROCOPY, the kernel then sends from our messages
+// directly rather than copying them into its own buffer, and notifies us via the socket's error queue when it finished using them, until then,
+// these messages are held (after they were reported as sent by on_msg_send and sync sending), so DO NOT modify messages in on_msg_send.
+//only plain tcp sockets (boost::asio::ip::tcp::socket) support it, ssl, websocket and unix domain sockets still send messages as usual.
+//please note:
+// 1. zero-copy has its own costs (pinning pages and handling notifications), it only pays off for big messages (10K+ per the kernel document).
+// 2. if the kernel reports that it copied the messages anyway (loopback for example), zero-copy will be given up for the connection.
+// 3. closing the connection waits for the notifications (if ASCS_DELAY_CLOSE is 0), but if the connection has been closed (the socket error
+//  for example) before the kernel notified us, no notifications will come any more, then held messages will be handed over to a process
+//  wide reaper, and be released at least ASCS_ZEROCOPY_REAP_DELAY seconds later (the kernel may still be sending them after the closing).
+#ifdef ASCS_ZEROCOPY_SEND
+	#ifndef __linux__
+		#error macro ASCS_ZEROCOPY_SEND is only supported on linux.
+	#endif
+	static_assert(BOOST_ASIO_VERSION > 101100, "zero-copy sending needs asio 1.12 or higher.");
+
+	#ifndef ASCS_ZEROCOPY_MIN_SIZE
+	#define ASCS_ZEROCOPY_MIN_SIZE	(16 * 1024)
+	#endif
+	static_assert(ASCS_ZEROCOPY_MIN_SIZE > 0, "the minimum size of zero-copy messages must be bigger than zero.");
+
+	#ifndef ASCS_ZEROCOPY_REAP_DELAY
+	#define ASCS_ZEROCOPY_REAP_DELAY	120 //seconds, closed connections don't linger in the kernel longer than this by default
+	#endif
+	static_assert(ASCS_ZEROCOPY_REAP_DELAY >= 0, "the delay of releasing orphaned zero-copy messages must be bigger than or equal to zero.");
+#endif
+
+//#define ASCS_INLINE_IO
+//with this macro, tcp::reader_writer tries a non-blocking read_some (write_some) in the IO strand before it issues async_read (async_write),
+// if it succeeded, call backs will be invoked immediately (so on_msg, on_msg_send and so on can be invoked inside send_msg and recv_msg
+// series if they're called in the IO strand, please note), otherwise (would block, partial writes or reads which need more data) the
+// asynchronous path takes over, this saves the round trips to the reactor and the completion queue in request/response patterns.
+//the price is one more system call (which returns EAGAIN) before every asynchronous read if there're no data in the kernel buffer.
+//only plain stream sockets (tcp and unix domain) support it, ssl and websocket still read and write asynchronously.
+//the socket will be put into non-blocking mode (boost::asio::basic_socket::non_blocking), don't change it.
+#ifdef ASCS_INLINE_IO
+static_assert(BOOST_ASIO_VERSION > 101100, "inline io needs asio 1.12 or higher.");
+#endif
+
+//#define ASCS_EXPIRE_SEND_MSG
+//with this macro, messages record the time when they entered the send buffer, and right before sending (in the IO strand), messages stayed
+// in the send buffer longer than ASCS_SEND_MSG_TTL milliseconds (can be changed via socket::send_msg_ttl at runtime, 0 means never expire)
+// will be dropped, virtual function on_msg_discard will be called with them and statistic::send_expired_msg_sum will be increased.
+//messages sent together (a message list, or a message split by the packer) expire together, the first one of them decides.
+//this is useful if stale messages are worthless (like quotes), when a stalled peer recovers, fresh messages will not be delayed by stale ones.
+#ifdef ASCS_EXPIRE_SEND_MSG
+	#ifndef ASCS_SEND_MSG_TTL
+	#define ASCS_SEND_MSG_TTL	1000 //milliseconds
+	#endif
+	static_assert(ASCS_SEND_MSG_TTL >= 0, "the ttl of messages must be bigger than or equal to zero.");
+#endif
+
 //buffer (on stack) size used when writing logs.
 #ifndef ASCS_UNIFIED_OUT_BUF_NUM
 #define ASCS_UNIFIED_OUT_BUF_NUM	2048
@@ -1015,6 +1236,8 @@ static_assert(ASCS_DELAY_CLOSE >= 0, "delay close duration must be bigger than o
 
 //after every msg sent, call ascs::socket::on_msg_send(InMsgType& msg)
 //this macro cannot exists with macro ASCS_WANT_BATCH_MSG_SEND_NOTIFY
+//for tcp, this macro doesn't disable batch sending (gather write) any more, after a batch of messages been sent, on_msg_send will be
+// invoked for each of them (in the sending order), so on_msg_send will be invoked after the whole batch been sent rather than each message.
 //#define ASCS_WANT_MSG_SEND_NOTIFY
 
 //after some msg sent, call tcp::socket_base::on_msg_send(typename super::in_container_type& msg_can)
@@ -1188,12 +1411,60 @@ static_assert(ASCS_HEARTBEAT_MAX_ABSENCE > 0, "heartbeat absence must be bigger
 //#define ASCS_ALWAYS_SEND_HEARTBEAT
 //always send heartbeat in each ASCS_HEARTBEAT_INTERVAL seconds without checking if we're sending other messages or not.
 
+//#define ASCS_HEARTBEAT_SCHEDULER
+//heartbeat of all sockets in the same io_context will be checked by one scheduler (see heartbeat_scheduler.h) which only uses one asio timer,
+// rather than each socket owns a timer (TIMER_HEARTBEAT_CHECK), this can significantly reduce wakeups if you have a huge number of links.
+#ifndef ASCS_HEARTBEAT_SWEEP_BATCH
+#define ASCS_HEARTBEAT_SWEEP_BATCH	1024
+#endif
+static_assert(ASCS_HEARTBEAT_SWEEP_BATCH > 0, "the batch size of heartbeat sweeping must be bigger than zero.");
+//at most this amount of sockets will be checked in one handler, the rest will be checked in subsequent handlers, to avoid blocking other events.
+
 //#define ASCS_AVOID_AUTO_STOP_SERVICE
 //wrap service_pump with boost::asio::io_service::work (boost::asio::executor_work_guard), then it will never run out until you explicitly call stop_service().
 
 //#define ASCS_DECREASE_THREAD_AT_RUNTIME
 //enable decreasing service thread at runtime.
 
+//#define ASCS_CPU_AFFINITY
+//enable binding service threads of each io_context to a set of CPUs (and mark the io_context as belonging to a NUMA node), see
+// service_pump::set_io_context_affinity for more details. with it, service_pump::assign_io_context will prefer io_contexts on the NUMA node
+// which the calling thread prefers (service threads automatically prefer their own node), so sockets created in service threads (for example,
+// accepted ones) will be put onto the same node as the acceptor, and memory allocated by them will be node-local (first touch policy).
+//only linux and windows are supported, on other platforms, only the preference of NUMA node works.
+
+//members of ascs::socket (and its subclasses) and statistic are ordered by their writers (threads which send messages, the IO strand and
+// the dispatch strand), this is only a field reordering, by default (0), no paddings are inserted between the groups and nothing changes
+// on false sharing. define this macro as the cache line size of your CPU (64 for most x86_64, 128 for some arm64) to insert paddings of
+// this size between the groups, which costs several hundreds of bytes per socket. whether it helps has not been measured, please measure it
+// yourself with demo cache_line_benchmark (perf c2c) before using it.
+//the staging lanes of macro ASCS_SEND_STAGING are always separated, see ASCS_SEND_STAGING_PADDING_SIZE.
+#ifndef ASCS_CACHE_LINE_SIZE
+#define ASCS_CACHE_LINE_SIZE	0
+#endif
+static_assert(ASCS_CACHE_LINE_SIZE >= 0, "the size of cache line must be bigger than or equal to zero.");
+#if ASCS_CACHE_LINE_SIZE > 0
+	#define ASCS_CACHE_LINE_PADDING(name) char name[ASCS_CACHE_LINE_SIZE];
+#else
+	#define ASCS_CACHE_LINE_PADDING(name)
+#endif
+
+//#define ASCS_HUGE_PAGE_ARENA
+//allocate objects that belong to sockets (sockets themselves, packers and unpackers, so unpackers' buffers are included) from huge_page_arena,
+// which carves memory from huge pages (explicit hugetlbfs pages first, then transparent huge pages, then normal pages), this can significantly
+// reduce TLB misses if you have a huge number of links. only linux supports huge pages, on other platforms, normal memory will be used.
+//please note that memory allocated from huge_page_arena will never be returned to the operating system.
+#ifndef ASCS_HUGE_PAGE_SIZE
+#define ASCS_HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+#endif
+static_assert(ASCS_HUGE_PAGE_SIZE > 0 && 0 == (ASCS_HUGE_PAGE_SIZE & (ASCS_HUGE_PAGE_SIZE - 1)), "huge page size must be a power of 2.");
+
+#ifndef ASCS_HUGE_PAGE_ARENA_ALIGNMENT
+#define ASCS_HUGE_PAGE_ARENA_ALIGNMENT	64 //the size of cache line
+#endif
+static_assert(ASCS_HUGE_PAGE_ARENA_ALIGNMENT >= 16 && 0 == (ASCS_HUGE_PAGE_ARENA_ALIGNMENT & (ASCS_HUGE_PAGE_ARENA_ALIGNMENT - 1)),
+	"the alignment of huge_page_arena must be a power of 2 and not less than 16.");
+
 #ifndef ASCS_MSG_RESUMING_INTERVAL
 #define ASCS_MSG_RESUMING_INTERVAL	50 //milliseconds
 #endif
@@ -1222,6 +1493,45 @@ static_assert(ASCS_MSG_HANDLING_INTERVAL >= 0, "the interval of msg handling mus
 // 1. it can also fix the situation i described for macro ASCS_EXPOSE_SEND_INTERFACE,
 // 2. it brings better effeciency for specific ENV, try to find them by you own.
 
+//#define ASCS_CONSOLIDATE_FLUSH
+//during a handler batch (on_msg or on_msg_handle) of a socket, messages sent to the same socket (from the same thread) only mark the socket as dirty,
+// and the send buffer will be flushed once at the end of the handler batch, so replying many messages produces one gather write rather than
+// many small writes (the first reply would be written alone otherwise), this can significantly reduce syscalls for request/response workloads.
+//sync sending (sync_send_msg series) and waiting for the send buffer (safe_send_msg series) flush deferred messages before blocking, otherwise
+// they will wait for the flush which only happens after the handler returns. but the handler batch still blocks the thread, so other things
+// which need to wait for the end of the handler batch (for example, sending the same socket from other threads while the buffer is full) see
+// at most one handler batch of delay, and sending to a socket from its own handler via sync_send_msg costs one write per message, please note.
+
+//#define ASCS_SEND_STAGING
+//if many threads send messages to the same socket concurrently, they all contend on the mutex of the send buffer, define this macro to let
+// each thread claim one of ASCS_SEND_STAGING_LANE_NUM staging lanes of the socket at its first sending, a lane is a lock-free single producer
+// single consumer ring which can hold ASCS_SEND_STAGING_LANE_SIZE messages, and only the thread which stages the first message since the last
+// harvesting triggers sending, then the IO strand harvests all lanes into the send buffer in one pass right before each write.
+//a lane will not be released until the socket is reset, threads which cannot claim a lane and threads whose lane is full fall back to the
+// send buffer (with its mutex).
+//messages from the same thread keep their order, but messages from different threads can be sent in an order other than the calling order,
+// prior messages (prior = true) bypass the staging lanes. each socket costs ASCS_SEND_STAGING_LANE_NUM * ASCS_SEND_STAGING_LANE_SIZE in_msg
+// objects, so only define this macro if you have a few sockets but many producers per socket.
+#ifdef ASCS_SEND_STAGING
+	#ifndef ASCS_SEND_STAGING_LANE_NUM
+	#define ASCS_SEND_STAGING_LANE_NUM	8
+	#endif
+	static_assert(ASCS_SEND_STAGING_LANE_NUM > 0, "the number of send staging lanes must be bigger than zero.");
+
+	#ifndef ASCS_SEND_STAGING_LANE_SIZE
+	#define ASCS_SEND_STAGING_LANE_SIZE	64
+	#endif
+	static_assert(ASCS_SEND_STAGING_LANE_SIZE > 0, "the size of send staging lanes must be bigger than zero.");
+
+	//lanes are written by different threads, so the head and tail of each lane are always kept in different cache lines (no matter what
+	// ASCS_CACHE_LINE_SIZE is) by byte paddings of this size (alignas doesn't work for heap objects before c++17).
+	#if ASCS_CACHE_LINE_SIZE > 64
+	#define ASCS_SEND_STAGING_PADDING_SIZE	ASCS_CACHE_LINE_SIZE
+	#else
+	#define ASCS_SEND_STAGING_PADDING_SIZE	64
+	#endif
+#endif
+
 //#define ASCS_PASSIVE_RECV
 //to gain the ability of changing the unpacker at runtime, with this macro, ascs will not do message receiving automatically (except
 // the first one, if macro ASCS_SYNC_RECV been defined, the first one will be omitted too), so you need to manually call recv_msg(),
@@ -1237,21 +1547,75 @@ static_assert(ASCS_MSG_HANDLING_INTERVAL >= 0, "the interval of msg handling mus
 //it's very useful if you want to re-dispatch message in your own logic or with very simple message handling (such as echo server).
 //it's your responsibility to remove handled messages from the container (can be a part of them).
 
+//#define ASCS_DISPATCH_SPAN_MSG
+//all messages will be dispatched via on_msg_handle with a contiguous span (obj_span) of messages, which is backed by a vector owned by the socket
+// (so its memory will be reused), this will change the signature of function on_msg_handle, it's friendlier to the CPU cache than ASCS_DISPATCH_BATCH_MSG.
+//return the number of handled messages (must be at the front of the span), the rest will be dispatched again.
+#if defined(ASCS_DISPATCH_SPAN_MSG) && defined(ASCS_DISPATCH_BATCH_MSG)
+	#error macro ASCS_DISPATCH_SPAN_MSG and ASCS_DISPATCH_BATCH_MSG cannot be defined at the same time.
+#endif
+
+#ifndef ASCS_DISPATCH_BUDGET_MSG_NUM
+#define ASCS_DISPATCH_BUDGET_MSG_NUM	1
+#endif
+static_assert(ASCS_DISPATCH_BUDGET_MSG_NUM > 0, "the message number budget of dispatching must be bigger than zero.");
+#ifndef ASCS_DISPATCH_BUDGET_DURATION
+#define ASCS_DISPATCH_BUDGET_DURATION	0 //microseconds, 0 means no limitation
+#endif
+static_assert(ASCS_DISPATCH_BUDGET_DURATION >= 0, "the duration budget of dispatching must be bigger than or equal to zero.");
+//without macro ASCS_DISPATCH_BATCH_MSG and ASCS_DISPATCH_SPAN_MSG, on_msg_handle will be called for at most ASCS_DISPATCH_BUDGET_MSG_NUM messages or
+// ASCS_DISPATCH_BUDGET_DURATION microseconds (whichever comes first) in one post (to dis_strand) before yielding, bigger budget means less scheduler round trips (higher throughput),
+// smaller budget means better fairness between sockets. the default value (1 message) is the behavior of older editions.
+//these values can be changed via ascs::socket::dispatch_budget(size_t, unsigned) at runtime.
+
+//#define ASCS_ADAPTIVE_DISPATCH_BUDGET
+#ifndef ASCS_DISPATCH_DELAY_TARGET
+#define ASCS_DISPATCH_DELAY_TARGET	1000 //microseconds
+#endif
+static_assert(ASCS_DISPATCH_DELAY_TARGET > 0, "the target of dispatch delay must be bigger than zero.");
+//adjust the message number budget (between 1 and ASCS_DISPATCH_BUDGET_MSG_NUM) according to the dispatch delay of each post, if it exceeds
+// ASCS_DISPATCH_DELAY_TARGET microseconds and the budget been used up (we're falling behind), double the budget, if it falls below half of
+// ASCS_DISPATCH_DELAY_TARGET, halve the budget. needs macro ASCS_FULL_STATISTIC to measure the dispatch delay.
+#if defined(ASCS_ADAPTIVE_DISPATCH_BUDGET) && !defined(ASCS_FULL_STATISTIC)
+	#error macro ASCS_ADAPTIVE_DISPATCH_BUDGET needs macro ASCS_FULL_STATISTIC.
+#endif
+
 //#define ASCS_ALIGNED_TIMER
 //for example, start a timer at xx:xx:xx, interval is 10 seconds, the callback will be called at (xx:xx:xx + 10), and suppose that the callback
 //returned at (xx:xx:xx + 11), then the interval will be temporarily changed to 9 seconds to make the next callback to be called at (xx:xx:xx + 20),
 //if you don't define this macro, the next callback will be called at (xx:xx:xx + 21), please note.
 
-//#define ASCS_SYNC_SEND
-//before 1.12.2, asio has a problem or no ability with the detection of std::future availability with libstdc++.
-#if BOOST_ASIO_VERSION >= 101202
-	#ifdef ASCS_SYNC_SEND
-		#ifndef BOOST_ASIO_HAS_STD_FUTURE
-		#define BOOST_ASIO_HAS_STD_FUTURE	0
-		#endif
-		static_assert(BOOST_ASIO_HAS_STD_FUTURE == 1, "sync message sending needs std::future.");
-	#endif
+#ifndef ASCS_TIMER_SLOT_NUM
+#define ASCS_TIMER_SLOT_NUM	32
+#endif
+static_assert(ASCS_TIMER_SLOT_NUM > 0 && ASCS_TIMER_SLOT_NUM <= 65536, "timer slot number must be between 1 and 65536.");
+//timers whose id is less than this value will be indexed by an array (in each timer object), so finding them (is_timer, start_timer, stop_timer
+// and so on) doesn't need any locks, other timers need a mutex and a linear search. all timers ascs uses are less than 32.
+
+//#define ASCS_TIMING_WHEEL
+//all timers in the same io_context will be managed by a hierarchical timing wheel (see timing_wheel.h) which only uses one asio timer, rather than
+// each timer owns an asio timer, arming and canceling timers are O(1). this can significantly reduce resource usage if you have a huge number of links.
+//with this macro, timers are aligned to ticks (ASCS_TIMING_WHEEL_TICK milliseconds), and canceled timers' handlers will be discarded without invocation.
+#ifndef ASCS_TIMING_WHEEL_TICK
+#define ASCS_TIMING_WHEEL_TICK	10 //milliseconds
 #endif
+static_assert(ASCS_TIMING_WHEEL_TICK > 0, "the tick of timing wheel must be bigger than zero.");
+
+#ifndef ASCS_TIMING_WHEEL_LEVEL
+#define ASCS_TIMING_WHEEL_LEVEL	4 //each level has 256 slots, so 4 levels cover 2^32 ticks
+#endif
+static_assert(ASCS_TIMING_WHEEL_LEVEL > 0 && ASCS_TIMING_WHEEL_LEVEL < 8, "the level of timing wheel must be between 1 and 7.");
+
+//#define ASCS_NON_HASHED_STRAND
+//use boost::asio::strand<boost::asio::io_context::executor_type> instead of boost::asio::io_context::strand as rw_strand and dis_strand,
+// the former owns its own implementation, while the latter hashes into a fixed pool (193 by default) of implementations, so unrelated sockets
+// can share an implementation and block each other (head-of-line blocking), this becomes noticeable if you have a huge number of links
+// and some of them handle messages slowly. the cost is one allocation per strand. run demo strand_benchmark to see the differences.
+#ifdef ASCS_NON_HASHED_STRAND
+static_assert(BOOST_ASIO_VERSION > 101100, "non-hashed strand needs asio 1.12 or higher.");
+#endif
+
+//#define ASCS_SYNC_SEND
 //#define ASCS_SYNC_RECV
 //define these macro to gain additional series of sync message sending and receiving, they are:
 // sync_send_msg
@@ -1266,6 +1630,8 @@ static_assert(ASCS_MSG_HANDLING_INTERVAL >= 0, "the interval of msg handling mus
 // with macro ASCS_PASSIVE_RECV, in sync_recv_msg(), recv_msg() will be automatically called, but the first one (right after the connection been established)
 //  will be omitted too, see macro ASCS_PASSIVE_RECV for more details.
 // after returned from sync_recv_msg(), ascs will not maintain those messages any more.
+// sync_recv_msg(msg_can, max_num, min_num, duration) waits until at least min_num messages been received (across many receivings), at most
+//  max_num messages will be taken, the rest will be dispatched asynchronously as usual.
 
 //Sync operations are not tracked by tracked_executor, please note.
 //Sync operations can be performed with async operations concurrently.
@@ -95,6 +95,8 @@ public:
 	bool try_dequeue(reference item) {typename Lockable::lock_guard lock(*this); return try_dequeue_(item);}
 	void move_items_out(Container& dest, size_t max_item_num = -1) {typename Lockable::lock_guard lock(*this); move_items_out_(dest, max_item_num);}
 	void move_items_out(size_t max_size_in_byte, Container& dest) {typename Lockable::lock_guard lock(*this); move_items_out_(max_size_in_byte, dest);}
+	void move_items_out(size_t max_size_in_byte, size_t max_item_num, Container& dest)
+		{typename Lockable::lock_guard lock(*this); move_items_out_(max_size_in_byte, max_item_num, dest);}
 	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred) {typename Lockable::lock_guard lock(*this); do_something_to_all_(__pred);}
 	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred) {typename Lockable::lock_guard lock(*this); do_something_to_one_(__pred);}
 	//thread safe
@@ -189,6 +191,23 @@ public:
 		}
 	}
 
+	//stop at whichever limit reached first, at least one item will be moved out (if any)
+	void move_items_out_(size_t max_size_in_byte, size_t max_item_num, Container& dest)
+	{
+		if ((size_t) -1 == max_item_num)
+			move_items_out_(max_size_in_byte, dest);
+		else if ((size_t) -1 == max_size_in_byte)
+			move_items_out_(dest, max_item_num);
+		else if (max_item_num > 0)
+		{
+			size_t size = 0, index = 0;
+			auto end_iter = this->begin();
+			do_something_to_one_([&](const_reference item) {size += item.size(); ++end_iter; return size >= max_size_in_byte || ++index >= max_item_num;});
+
+			move_items_out(dest, end_iter, size);
+		}
+	}
+
 	template<typename _Predicate>
 	void do_something_to_all_(const _Predicate& __pred) {for (auto& item : *this) __pred(item);}
 	template<typename _Predicate>
@@ -22,6 +22,14 @@
 namespace ascs
 {
 
+#ifdef ASCS_NON_HASHED_STRAND
+typedef boost::asio::strand<boost::asio::io_context::executor_type> strand_type;
+inline strand_type create_strand(boost::asio::io_context& io_context_) {return strand_type(io_context_.get_executor());}
+#else
+typedef boost::asio::io_context::strand strand_type;
+inline strand_type create_strand(boost::asio::io_context& io_context_) {return strand_type(io_context_);}
+#endif
+
 class executor
 {
 protected:
@@ -35,14 +43,14 @@ public:
 	template<typename F> void post(F&& handler) {boost::asio::post(io_context_, std::forward<F>(handler));}
 	template<typename F> void defer(F&& handler) {boost::asio::defer(io_context_, std::forward<F>(handler));}
 	template<typename F> void dispatch(F&& handler) {boost::asio::dispatch(io_context_, std::forward<F>(handler));}
-	template<typename F> void post_strand(boost::asio::io_context::strand& strand, F&& handler) {boost::asio::post(strand, std::forward<F>(handler));}
-	template<typename F> void defer_strand(boost::asio::io_context::strand& strand, F&& handler) {boost::asio::defer(strand, std::forward<F>(handler));}
-	template<typename F> void dispatch_strand(boost::asio::io_context::strand& strand, F&& handler) {boost::asio::dispatch(strand, std::forward<F>(handler));}
+	template<typename F> void post_strand(strand_type& strand, F&& handler) {boost::asio::post(strand, std::forward<F>(handler));}
+	template<typename F> void defer_strand(strand_type& strand, F&& handler) {boost::asio::defer(strand, std::forward<F>(handler));}
+	template<typename F> void dispatch_strand(strand_type& strand, F&& handler) {boost::asio::dispatch(strand, std::forward<F>(handler));}
 #else
 	template<typename F> void post(F&& handler) {io_context_.post(std::forward<F>(handler));}
 	template<typename F> void dispatch(F&& handler) {io_context_.dispatch(std::forward<F>(handler));}
-	template<typename F> void post_strand(boost::asio::io_context::strand& strand, F&& handler) {strand.post(std::forward<F>(handler));}
-	template<typename F> void dispatch_strand(boost::asio::io_context::strand& strand, F&& handler) {strand.dispatch(std::forward<F>(handler));}
+	template<typename F> void post_strand(strand_type& strand, F&& handler) {strand.post(std::forward<F>(handler));}
+	template<typename F> void dispatch_strand(strand_type& strand, F&& handler) {strand.dispatch(std::forward<F>(handler));}
 #endif
 
 	template<typename F> inline F&& make_handler_error(F&& f) const {return std::forward<F>(f);}
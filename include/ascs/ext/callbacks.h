@@ -48,6 +48,9 @@ public:
 	typedef void fo_send_heartbeat(Socket*);
 	typedef void fo_reset(Socket*);
 	typedef bool fo_on_heartbeat_error(Socket*);
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	typedef bool fo_on_consumer_state_change(Socket*, consumer_state, consumer_state);
+#endif
 	typedef void fo_on_send_error(Socket*, const boost::system::error_code&, typename Socket::in_container_type&);
 	typedef void fo_on_recv_error(Socket*, const boost::system::error_code&);
 	typedef void fo_on_close(Socket*);
@@ -56,7 +59,9 @@ public:
 #ifdef ASCS_SYNC_DISPATCH
 	typedef size_t fo_on_msg(Socket*, std::list<typename Socket::out_msg_type>&);
 #endif
-#ifdef ASCS_DISPATCH_BATCH_MSG
+#ifdef ASCS_DISPATCH_SPAN_MSG
+	typedef size_t fo_on_msg_handle(Socket*, obj_span<typename Socket::out_msg>);
+#elif defined(ASCS_DISPATCH_BATCH_MSG)
 	typedef size_t fo_on_msg_handle(Socket*, typename Socket::out_queue_type&);
 #else
 	typedef bool fo_on_msg_handle(Socket*, typename Socket::out_msg_type&);
@@ -71,6 +76,8 @@ public:
 
 #ifdef ASCS_SHRINK_SEND_BUFFER
 	typedef size_t fo_calc_shrink_size(Socket*, size_t);
+#endif
+#if defined(ASCS_SHRINK_SEND_BUFFER) || defined(ASCS_EXPIRE_SEND_MSG)
 	typedef void fo_on_msg_discard(Socket*, typename Socket::in_container_type&);
 #endif
 
@@ -82,6 +89,9 @@ public:
 	register_cb_1(send_heartbeat, false)
 	register_cb_1(reset, true)
 	register_cb_1(on_heartbeat_error, true)
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	register_cb_3(on_consumer_state_change, true)
+#endif
 	register_cb_3(on_send_error, true)
 	register_cb_2(on_recv_error, true)
 	register_cb_1(on_close, true)
@@ -98,6 +108,8 @@ public:
 #endif
 #ifdef ASCS_SHRINK_SEND_BUFFER
 	register_cb_2(calc_shrink_size, false)
+#endif
+#if defined(ASCS_SHRINK_SEND_BUFFER) || defined(ASCS_EXPIRE_SEND_MSG)
 	register_cb_2(on_msg_discard, false)
 #endif
 
@@ -109,6 +121,10 @@ private:
 	call_cb_combine(Socket, is_ready)
 	call_cb_void(Socket, send_heartbeat)
 	call_cb_combine(Socket, on_heartbeat_error)
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	virtual bool on_consumer_state_change(consumer_state prev_state, consumer_state state)
+		call_cb_2_combine(Socket, on_consumer_state_change, prev_state, state)
+#endif
 	virtual void on_send_error(const boost::system::error_code& ec, typename Socket::in_container_type& msg_can) call_cb_2_void(Socket, on_send_error, ec, msg_can)
 	virtual void on_recv_error(const boost::system::error_code& ec) call_cb_1_void(Socket, on_recv_error, ec)
 	call_cb_void(Socket, on_close)
@@ -117,7 +133,9 @@ private:
 #ifdef ASCS_SYNC_DISPATCH
 	virtual size_t on_msg(std::list<typename Socket::out_msg_type>& msg_can) call_cb_1_return(Socket, size_t, on_msg, msg_can)
 #endif
-#ifdef ASCS_DISPATCH_BATCH_MSG
+#ifdef ASCS_DISPATCH_SPAN_MSG
+	virtual size_t on_msg_handle(obj_span<typename Socket::out_msg> msg_span) call_cb_1_return(Socket, size_t, on_msg_handle, msg_span)
+#elif defined(ASCS_DISPATCH_BATCH_MSG)
 	virtual size_t on_msg_handle(typename Socket::out_queue_type& msg_can) call_cb_1_return(Socket, size_t, on_msg_handle, msg_can)
 #else
 	virtual bool on_msg_handle(typename Socket::out_msg_type& msg) call_cb_1_combine(Socket, on_msg_handle, msg)
@@ -132,6 +150,8 @@ private:
 
 #ifdef ASCS_SHRINK_SEND_BUFFER
 	virtual size_t calc_shrink_size(size_t current_size) call_cb_1_return(Socket, size_t, calc_shrink_size, current_size)
+#endif
+#if defined(ASCS_SHRINK_SEND_BUFFER) || defined(ASCS_EXPIRE_SEND_MSG)
 	virtual void on_msg_discard(typename Socket::in_container_type& msg_can) call_cb_1_void(Socket, on_msg_discard, msg_can)
 #endif
 
@@ -141,6 +161,9 @@ private:
 	std::pair<std::function<fo_send_heartbeat>, bool> cb_send_heartbeat;
 	std::pair<std::function<fo_reset>, bool> cb_reset;
 	std::pair<std::function<fo_on_heartbeat_error>, bool> cb_on_heartbeat_error;
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	std::pair<std::function<fo_on_consumer_state_change>, bool> cb_on_consumer_state_change;
+#endif
 	std::pair<std::function<fo_on_send_error>, bool> cb_on_send_error;
 	std::pair<std::function<fo_on_recv_error>, bool> cb_on_recv_error;
 	std::pair<std::function<fo_on_close>, bool> cb_on_close;
@@ -159,6 +182,8 @@ private:
 
 #ifdef ASCS_SHRINK_SEND_BUFFER
 	std::pair<std::function<fo_calc_shrink_size>, bool> cb_calc_shrink_size;
+#endif
+#if defined(ASCS_SHRINK_SEND_BUFFER) || defined(ASCS_EXPIRE_SEND_MSG)
 	std::pair<std::function<fo_on_msg_discard>, bool> cb_on_msg_discard;
 #endif
 };
@@ -27,6 +27,8 @@
 
 //#define ASCS_SCATTERED_RECV_BUFFER
 //define this macro will introduce scatter-gather buffers when doing async read, it's very useful under certain situations (for example, ring buffer).
+//with it, the default unpacker becomes a ring buffer, it reads into both the free space after and before its wrap around, so it never moves
+// half-baked msgs, ASCS_RECV_BUFFER_TYPE must be a container of buffers (for example, std::vector<boost::asio::mutable_buffer>).
 //this macro is used by unpackers only, it doesn't belong to ascs.
 
 #ifdef ASCS_HUGE_MSG
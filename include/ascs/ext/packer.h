@@ -99,6 +99,28 @@ public:
 
 		return msg;
 	}
+	virtual bool append_msg(typename super::msg_type& slab, const char* const pstr[], const size_t len[], size_t num, bool native = false)
+	{
+		auto pre_len = native ? 0 : ASCS_HEAD_LEN;
+		auto total_len = packer_helper::msg_size_check(pre_len, pstr, len, num);
+		if ((size_t) -1 == total_len || total_len <= pre_len)
+			return false; //let pack_msg report the error
+		else if (!native)
+		{
+			auto head_len = (ASCS_HEAD_TYPE) total_len;
+			if (total_len != head_len)
+				return false;
+
+			head_len = ASCS_HEAD_H2N(head_len);
+			slab.append((const char*) &head_len, ASCS_HEAD_LEN);
+		}
+
+		for (size_t i = 0; i < num; ++i)
+			if (nullptr != pstr[i])
+				slab.append(pstr[i], len[i]);
+
+		return true;
+	}
 	virtual bool pack_msg(typename super::msg_type&& msg, typename super::container_type& msg_can)
 	{
 		auto len = msg.size();
@@ -267,6 +289,23 @@ public:
 
 		return msg;
 	}
+	virtual bool append_msg(msg_type& slab, const char* const pstr[], const size_t len[], size_t num, bool native = false)
+	{
+		auto pre_len = native ? 0 : _prefix.size() + _suffix.size();
+		auto total_len = packer_helper::msg_size_check(pre_len, pstr, len, num);
+		if ((size_t) -1 == total_len || total_len <= pre_len)
+			return false; //let pack_msg report the error
+
+		if (!native)
+			slab.append(_prefix);
+		for (size_t i = 0; i < num; ++i)
+			if (nullptr != pstr[i])
+				slab.append(pstr[i], len[i]);
+		if (!native)
+			slab.append(_suffix);
+
+		return true;
+	}
 	virtual bool pack_msg(msg_type&& msg, container_type& msg_can)
 	{
 		auto len = _prefix.size() + msg.size() + _suffix.size();
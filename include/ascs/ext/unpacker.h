@@ -50,6 +50,10 @@ public:
 
 //protocol: length + body
 //T can be std::string or basic_buffer
+//with macro ASCS_SCATTERED_RECV_BUFFER, raw_buff is a ring buffer, prepare_next_recv returns both the free space after and before the wrap
+// around, so unparsed data (half-baked msg) will never be moved, messages which straddle the wrap around will be assembled when they're
+// copied out (then parse_msg(std::list<std::pair<const char*, size_t>>&) is not available). otherwise, unparsed data will be moved to
+// the head of raw_buff after every reading.
 template<typename T = std::string>
 class unpacker : public i_unpacker<T>
 {
@@ -59,6 +63,58 @@ private:
 public:
 	size_t current_msg_length() const {return cur_msg_len;} //current msg's total length, -1 means not available
 
+#ifdef ASCS_SCATTERED_RECV_BUFFER
+	virtual void reset() {cur_msg_len = -1; remain_len = data_begin = 0;}
+	virtual void dump_left_data() const
+	{
+		std::string data(remain_len, '\0');
+		peek(0, &*std::begin(data), remain_len);
+		unpacker_helper::dump_left_data(data.data(), cur_msg_len, remain_len);
+	}
+	virtual bool parse_msg(size_t bytes_transferred, typename super::container_type& msg_can)
+	{
+		//length + msg
+		remain_len += bytes_transferred;
+		assert(remain_len <= ASCS_MSG_BUFFER_SIZE);
+
+		auto old_remain_len = remain_len;
+		for (;;) //considering sticky package problem, we need a loop
+			if ((size_t) -1 != cur_msg_len)
+			{
+				if (cur_msg_len > ASCS_MSG_BUFFER_SIZE || cur_msg_len < ASCS_HEAD_LEN)
+					return false; //if unpacking failed, successfully parsed msgs will still returned via msg_can(sticky package), please note.
+				else if (remain_len >= cur_msg_len) //one msg received
+				{
+					if (cur_msg_len > ASCS_HEAD_LEN) //ignore heartbeat
+					{
+						if (this->stripped())
+							copy_msg_out(ASCS_HEAD_LEN, cur_msg_len - ASCS_HEAD_LEN, msg_can);
+						else
+							copy_msg_out(0, cur_msg_len, msg_can);
+					}
+
+					consume(cur_msg_len);
+					cur_msg_len = -1;
+				}
+				else
+					break;
+			}
+			else if (remain_len >= ASCS_HEAD_LEN) //the msg's head been received, sticky package found
+			{
+				ASCS_HEAD_TYPE head;
+				peek(0, (char*) &head, ASCS_HEAD_LEN);
+				cur_msg_len = ASCS_HEAD_N2H(head);
+#ifdef ASCS_HUGE_MSG
+				if ((size_t) -1 == cur_msg_len) //avoid dead loop on 32bit system with macro ASCS_HUGE_MSG
+					return false;
+#endif
+			}
+			else
+				break;
+
+		return remain_len < old_remain_len; //we should have at least got one msg.
+	}
+#else
 	bool parse_msg(std::list<std::pair<const char*, size_t>>& msg_can)
 	{
 		auto pnext = &*std::begin(raw_buff);
@@ -127,6 +183,7 @@ public:
 		//if unpacking failed, successfully parsed msgs will still returned via msg_can(sticky package), please note.
 		return unpack_ok;
 	}
+#endif
 
 	//a return value of 0 indicates that the read operation is complete. a non-zero value indicates the maximum number
 	//of bytes to be read on the next call to the stream's async_read_some function. ---boost::asio::async_read
@@ -142,7 +199,11 @@ public:
 		if ((size_t) -1 == cur_msg_len && data_len >= ASCS_HEAD_LEN) //the msg's head been received
 		{
 			ASCS_HEAD_TYPE head;
+#ifdef ASCS_SCATTERED_RECV_BUFFER
+			peek(0, (char*) &head, ASCS_HEAD_LEN);
+#else
 			memcpy(&head, &*std::begin(raw_buff), ASCS_HEAD_LEN);
+#endif
 			cur_msg_len = ASCS_HEAD_N2H(head);
 			if (cur_msg_len > ASCS_MSG_BUFFER_SIZE || cur_msg_len < ASCS_HEAD_LEN) //invalid msg, stop reading
 				return 0;
@@ -153,9 +214,18 @@ public:
 	}
 
 #ifdef ASCS_SCATTERED_RECV_BUFFER
-	//this is just to satisfy the compiler, it's not a real scatter-gather buffer,
-	//if you introduce a ring buffer, then you will have the chance to provide a real scatter-gather buffer.
-	virtual typename super::buffer_type prepare_next_recv() {assert(remain_len < ASCS_MSG_BUFFER_SIZE); return typename super::buffer_type(1, boost::asio::buffer(raw_buff) + remain_len);}
+	virtual typename super::buffer_type prepare_next_recv()
+	{
+		assert(remain_len < ASCS_MSG_BUFFER_SIZE);
+		auto data_end = wrap(data_begin + remain_len);
+		typename super::buffer_type buff(1, boost::asio::buffer(raw_buff) + data_end);
+		if (data_end >= data_begin && data_begin > 0) //the free space wraps around
+			buff.emplace_back(boost::asio::buffer(raw_buff.data(), data_begin));
+		else if (data_end < data_begin)
+			buff.front() = boost::asio::buffer(buff.front(), data_begin - data_end);
+
+		return buff;
+	}
 #elif BOOST_ASIO_VERSION <= 101100
 	virtual typename super::buffer_type prepare_next_recv() {assert(remain_len < ASCS_MSG_BUFFER_SIZE); return boost::asio::buffer(boost::asio::buffer(raw_buff) + remain_len);}
 #else
@@ -167,10 +237,49 @@ public:
 	virtual const char* raw_data(typename super::msg_ctype& msg) const {return this->stripped() ? msg.data() : std::next(msg.data(), ASCS_HEAD_LEN);}
 	virtual size_t raw_data_len(typename super::msg_ctype& msg) const {return this->stripped() ? msg.size() : msg.size() - ASCS_HEAD_LEN;}
 
+#ifdef ASCS_SCATTERED_RECV_BUFFER
+protected:
+	static size_t wrap(size_t pos) {return pos >= ASCS_MSG_BUFFER_SIZE ? pos - ASCS_MSG_BUFFER_SIZE : pos;}
+
+	//copy len bytes which start at offset (relative to data_begin) out of the ring buffer
+	void peek(size_t offset, char* data, size_t len) const
+	{
+		auto begin = wrap(data_begin + offset);
+		auto first_len = std::min(len, ASCS_MSG_BUFFER_SIZE - begin);
+		memcpy(data, raw_buff.data() + begin, first_len);
+		if (len > first_len)
+			memcpy(data + first_len, raw_buff.data(), len - first_len);
+	}
+
+	void copy_msg_out(size_t offset, size_t len, typename super::container_type& msg_can)
+	{
+		auto begin = wrap(data_begin + offset);
+		if (begin + len <= ASCS_MSG_BUFFER_SIZE)
+			msg_can.emplace_back(raw_buff.data() + begin, len);
+		else //straddles the wrap around
+		{
+			msg_can.emplace_back();
+			auto& msg = msg_can.back();
+			msg.reserve(len);
+			msg.append(raw_buff.data() + begin, ASCS_MSG_BUFFER_SIZE - begin);
+			msg.append(raw_buff.data(), len - (ASCS_MSG_BUFFER_SIZE - begin));
+		}
+	}
+
+	void consume(size_t len)
+	{
+		remain_len -= len;
+		data_begin = 0 == remain_len ? 0 : wrap(data_begin + len); //rewind if possible, so the next reading is more likely to be contiguous
+	}
+#endif
+
 protected:
 	std::array<char, ASCS_MSG_BUFFER_SIZE> raw_buff;
 	size_t cur_msg_len = -1; //-1 means head not received, so msg length is not available.
 	size_t remain_len{0}; //half-baked msg
+#ifdef ASCS_SCATTERED_RECV_BUFFER
+	size_t data_begin{0}; //where the half-baked msg starts in raw_buff
+#endif
 };
 
 //protocol: length + body
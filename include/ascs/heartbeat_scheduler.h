@@ -0,0 +1,190 @@
+/*
+ * heartbeat_scheduler.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: youngwolf
+ *		email: mail2tao@163.com
+ *		QQ: 676218192
+ *		Community on QQ: 198941541
+ *
+ * heartbeat and idle detection scheduler, one for each io_context
+ */
+
+#ifndef _ASCS_HEARTBEAT_SCHEDULER_H_
+#define _ASCS_HEARTBEAT_SCHEDULER_H_
+
+#include <boost/asio/steady_timer.hpp>
+
+#include "base.h"
+
+namespace ascs
+{
+
+//it works as a boost::asio service, so each io_context has its own scheduler, all sockets in the same io_context that started heartbeat
+// share only one asio timer (ticks every second if there're registered checkers, otherwise it stops ticking), rather than each socket owns
+// a timer (TIMER_HEARTBEAT_CHECK).
+//the due time of all checkers are stored in a dense array, every tick, the scheduler sweeps it, copies (shared pointers of) due checkers out (at most
+// ASCS_HEARTBEAT_SWEEP_BATCH checkers in one batch, the rest will be swept in another post) and invokes them without holding the mutex.
+//checkers are invoked in sequence, so for the same socket, the checker will never be invoked concurrently.
+class heartbeat_scheduler : public boost::asio::detail::service_base<heartbeat_scheduler>
+{
+public:
+	typedef move_only_function<void(const boost::system::error_code&)> checker_type; //checkers can be move-only (see tracked_handler)
+
+	heartbeat_scheduler(boost::asio::io_context& io_context_) : service_base<heartbeat_scheduler>(io_context_), tick_timer(io_context_) {}
+
+	//index is owned by the caller, the scheduler updates it when the checker moves in the dense array, and sets it to -1 when removed,
+	// it must keep valid until the checker been removed. interval's unit is second.
+	//return false if the index already represents a checker.
+	bool add(size_t& index, int interval, checker_type&& checker)
+	{
+		assert(interval > 0);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if ((size_t) -1 != index)
+			return false;
+
+		index = due_times.size();
+		due_times.emplace_back(time(nullptr) + interval);
+		entries.emplace_back(index, interval, std::move(checker));
+
+		start_ticking();
+		return true;
+	}
+
+	//after this function returned, the checker will never be invoked again (except it has been copied out by the sweeper before removing,
+	// then it will be freed after the invocation, the checker should hold the owner's async call indicator, see tracked_executor, to prevent
+	// the owner from being freed in this situation).
+	bool remove(size_t& index)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if ((size_t) -1 == index)
+			return false;
+
+		assert(index < entries.size() && &index == entries[index].index);
+		if (sweeping) //keep the dense array stable during sweeping, compact it after sweeping
+		{
+			entries[index].checker = nullptr;
+			entries[index].index = nullptr;
+			++removed_num;
+		}
+		else
+			do_remove(index);
+		index = -1;
+
+		return true;
+	}
+
+	size_t size() const {return entries.size() - removed_num;} //registered checkers
+
+private:
+	struct entry
+	{
+		size_t* index;
+		int interval;
+		std::shared_ptr<checker_type> checker; //shared with the sweeper, so checkers are never copied
+
+		entry(size_t& index_, int interval_, checker_type&& checker_) :
+			index(&index_), interval(interval_), checker(std::make_shared<checker_type>(std::move(checker_))) {}
+	};
+
+#if BOOST_ASIO_VERSION >= 101100
+	virtual void shutdown()
+#else
+	virtual void shutdown_service()
+#endif
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& item : entries)
+			if (nullptr != item.index)
+				*item.index = -1;
+		entries.clear();
+		due_times.clear();
+		removed_num = 0;
+	}
+
+	void do_remove(size_t index) //swap with the last one, mutex must be held
+	{
+		auto last = entries.size() - 1;
+		if (index != last)
+		{
+			due_times[index] = due_times[last];
+			entries[index] = std::move(entries[last]);
+			if (nullptr != entries[index].index)
+				*entries[index].index = index;
+		}
+		due_times.pop_back();
+		entries.pop_back();
+	}
+
+	void start_ticking() //mutex must be held
+	{
+		if (ticking || sweeping || entries.empty())
+			return;
+
+		ticking = true;
+#if BOOST_ASIO_VERSION >= 101100
+		tick_timer.expires_after(std::chrono::seconds(1));
+#else
+		tick_timer.expires_from_now(std::chrono::seconds(1));
+#endif
+		tick_timer.async_wait([this](const boost::system::error_code& ec) {if (!ec) sweep(0);});
+	}
+
+	void sweep(size_t begin)
+	{
+		std::vector<std::shared_ptr<checker_type>> due_checkers;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ticking = false;
+			sweeping = true;
+
+			auto now = time(nullptr);
+			auto size = due_times.size();
+			for (; begin < size && due_checkers.size() < ASCS_HEARTBEAT_SWEEP_BATCH; ++begin)
+				if (due_times[begin] <= now && nullptr != entries[begin].index)
+				{
+					due_times[begin] = now + entries[begin].interval;
+					due_checkers.emplace_back(entries[begin].checker);
+				}
+
+			if (begin >= size)
+			{
+				sweeping = false;
+				for (auto i = entries.size(); removed_num > 0 && i > 0; --i)
+					if (nullptr == entries[i - 1].index)
+					{
+						do_remove(i - 1);
+						--removed_num;
+					}
+
+				start_ticking();
+			}
+		}
+
+		boost::system::error_code ec;
+		ascs::do_something_to_all(due_checkers, [&](const std::shared_ptr<checker_type>& item) {(*item)(ec);});
+		due_checkers.clear(); //release owners' async call indicators before sweeping the next batch
+
+		if (sweeping)
+#if BOOST_ASIO_VERSION >= 101100
+			boost::asio::post(get_io_context(), [this, begin]() {sweep(begin);});
+#else
+			get_io_context().post([this, begin]() {sweep(begin);});
+#endif
+	}
+
+private:
+	boost::asio::steady_timer tick_timer;
+	bool ticking{false};
+	bool sweeping{false}; //only the sweeper changes it, and no more than one sweeper at any time
+
+	std::vector<time_t> due_times; //dense array, parallel to entries
+	std::vector<entry> entries;
+	size_t removed_num{0};
+	std::mutex mutex;
+};
+
+} //namespace
+
+#endif /* _ASCS_HEARTBEAT_SCHEDULER_H_ */
@@ -167,7 +167,7 @@ protected:
 #define CREATE_OBJECT_1_ARG(first_way) \
 auto object_ptr = first_way(); \
 if (!object_ptr) \
-	try {object_ptr = std::make_shared<Object>(std::forward<Arg>(arg));} \
+	try {object_ptr = make_shared_object<Object>(std::forward<Arg>(arg));} \
 	catch (const std::exception& e) {unified_out::error_out("cannot create object (%s)", e.what());} \
 init_object(object_ptr); \
 return object_ptr;
@@ -175,7 +175,7 @@ return object_ptr;
 #define CREATE_OBJECT_2_ARG(first_way) \
 auto object_ptr = first_way(); \
 if (!object_ptr) \
-	try {object_ptr = std::make_shared<Object>(std::forward<Arg1>(arg1), std::forward<Arg2>(arg2));} \
+	try {object_ptr = make_shared_object<Object>(std::forward<Arg1>(arg1), std::forward<Arg2>(arg2));} \
 	catch (const std::exception& e) {unified_out::error_out("cannot create object (%s)", e.what());} \
 init_object(object_ptr); \
 return object_ptr;
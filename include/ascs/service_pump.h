@@ -15,6 +15,15 @@
 
 #include "base.h"
 
+#ifdef ASCS_CPU_AFFINITY
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#endif
+
 namespace ascs
 {
 
@@ -70,6 +79,10 @@ protected:
 #endif
 #endif
 		std::list<std::thread> threads;
+#ifdef ASCS_CPU_AFFINITY
+		std::vector<int> cpus; //empty means no affinity
+		int numa_node{-1}; //-1 means unknown
+#endif
 
 #if BOOST_ASIO_VERSION >= 101200
 		context(int concurrency_hint = BOOST_ASIO_CONCURRENCY_HINT_SAFE) : io_context(concurrency_hint), refs(0)
@@ -135,6 +148,27 @@ public:
 	virtual ~service_pump() {stop_service();}
 
 	int get_io_context_num() const {return (int) context_can.size();}
+#ifdef ASCS_CPU_AFFINITY
+	//bind all service threads of the index'th io_context to cpus, and mark the io_context as belonging to numa_node (-1 means unknown),
+	//call this after set_io_context_num but before start_service, not thread safe.
+	bool set_io_context_affinity(int index, const std::vector<int>& cpus, int numa_node = -1)
+	{
+		if (index < 0 || index >= get_io_context_num() || is_service_started())
+			return false;
+
+		auto iter = std::next(std::begin(context_can), index);
+		iter->cpus = cpus;
+		iter->numa_node = numa_node;
+
+		return true;
+	}
+
+	//the calling thread will prefer io_contexts on numa_node (-1 means no preference) in assign_io_context, if no io_context belongs to numa_node,
+	// fall back to all io_contexts. service threads automatically prefer their own node, so sockets created in them (for example, accepted ones)
+	// will be assigned to the same node, call this before constructing a server to put its acceptor onto the NIC-local node.
+	static void prefer_numa_node(int numa_node) {numa_node_preference() = numa_node;}
+	static int preferred_numa_node() {return numa_node_preference();}
+#endif
 	void get_io_context_refs(std::list<unsigned>& refs)
 		{if (!single_ctx) ascs::do_something_to_all(context_can, context_can_mutex, [&](context& item) {refs.emplace_back(item.refs);});}
 
@@ -153,6 +187,21 @@ public:
 		unsigned refs = 0;
 
 		std::lock_guard<std::mutex> lock(context_can_mutex);
+#ifdef ASCS_CPU_AFFINITY
+		auto numa_node = preferred_numa_node();
+		if (numa_node >= 0)
+			ascs::do_something_to_one(context_can, [&](context& item) {
+				if (numa_node == item.numa_node && (0 == item.refs || nullptr == ctx || refs > item.refs))
+				{
+					refs = item.refs;
+					ctx = &item;
+				}
+
+				return nullptr != ctx && 0 == ctx->refs;
+			});
+
+		if (nullptr == ctx)
+#endif
 		ascs::do_something_to_one(context_can, [&](context& item) {
 			if (0 == item.refs || 0 == refs || refs > item.refs)
 			{
@@ -406,6 +455,9 @@ protected:
 		std::stringstream os;
 		os << "service thread[" << std::this_thread::get_id() << "] begin.";
 		unified_out::info_out(os.str().data());
+#ifdef ASCS_CPU_AFFINITY
+		bind_thread(ctx);
+#endif
 
 #ifdef ASCS_DECREASE_THREAD_AT_RUNTIME
 		++real_thread_num;
@@ -455,6 +507,33 @@ protected:
 	DO_SOMETHING_TO_ONE_MUTEX(service_can, service_can_mutex, std::lock_guard<std::mutex>)
 
 private:
+#ifdef ASCS_CPU_AFFINITY
+	static int& numa_node_preference() {static thread_local int numa_node = -1; return numa_node;}
+
+	void bind_thread(const context* ctx)
+	{
+		numa_node_preference() = ctx->numa_node;
+		if (ctx->cpus.empty())
+			return;
+
+#ifdef _WIN32
+		DWORD_PTR mask = 0;
+		ascs::do_something_to_all(ctx->cpus, [&](int cpu) {if (cpu >= 0 && cpu < (int) sizeof(DWORD_PTR) * 8) mask |= (DWORD_PTR) 1 << cpu;});
+		if (0 == SetThreadAffinityMask(GetCurrentThread(), mask))
+			unified_out::error_out("failed to bind service thread to CPU(s), error: %u.", (unsigned) GetLastError());
+#elif defined(__linux__)
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		ascs::do_something_to_all(ctx->cpus, [&](int cpu) {if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &cpu_set);});
+		auto re = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+		if (0 != re)
+			unified_out::error_out("failed to bind service thread to CPU(s), error: %d.", re);
+#else
+		unified_out::warning_out("binding service thread to CPU(s) is not supported on this platform.");
+#endif
+	}
+#endif
+
 	context* assign_thread() //pick the context which has the least threads
 	{
 		context* ctx = nullptr;
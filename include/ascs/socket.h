@@ -16,6 +16,12 @@
 #include "tracked_executor.h"
 #include "timer.h"
 #include "container.h"
+#ifdef ASCS_HEARTBEAT_SCHEDULER
+#include "heartbeat_scheduler.h"
+#endif
+#ifdef ASCS_SEND_LINGER
+#include <boost/asio/steady_timer.hpp>
+#endif
 
 namespace ascs
 {
@@ -33,12 +39,21 @@ public:
 	static const tid TIMER_DISPATCH_MSG = TIMER_BEGIN + 1;
 	static const tid TIMER_DELAY_CLOSE = TIMER_BEGIN + 2;
 	static const tid TIMER_HEARTBEAT_CHECK = TIMER_BEGIN + 3;
+	static const tid TIMER_SLOW_CONSUMER_CHECK = TIMER_BEGIN + 4;
 	static const tid TIMER_END = TIMER_BEGIN + 10;
 
 protected:
-	socket(boost::asio::io_context& io_context_) : super(io_context_), rw_strand(io_context_), next_layer_(io_context_), dis_strand(io_context_) {}
+#ifdef ASCS_HEARTBEAT_SCHEDULER
+	socket(boost::asio::io_context& io_context_) : super(io_context_), rw_strand(create_strand(io_context_)), next_layer_(io_context_), dis_strand(create_strand(io_context_)),
+		hb_scheduler(boost::asio::use_service<heartbeat_scheduler>(io_context_)) {}
+	template<typename Arg> socket(boost::asio::io_context& io_context_, Arg&& arg) : super(io_context_), rw_strand(create_strand(io_context_)),
+		next_layer_(io_context_, std::forward<Arg>(arg)), dis_strand(create_strand(io_context_)), hb_scheduler(boost::asio::use_service<heartbeat_scheduler>(io_context_)) {}
+	~socket() {stop_heartbeat();}
+#else
+	socket(boost::asio::io_context& io_context_) : super(io_context_), rw_strand(create_strand(io_context_)), next_layer_(io_context_), dis_strand(create_strand(io_context_)) {}
 	template<typename Arg> socket(boost::asio::io_context& io_context_, Arg&& arg) :
-		super(io_context_), rw_strand(io_context_), next_layer_(io_context_, std::forward<Arg>(arg)), dis_strand(io_context_) {}
+		super(io_context_), rw_strand(create_strand(io_context_)), next_layer_(io_context_, std::forward<Arg>(arg)), dis_strand(create_strand(io_context_)) {}
+#endif
 
 	//guarantee no operations (include asynchronous operations) be performed on this socket during call following reset_next_layer functions.
 #if BOOST_ASIO_VERSION < 101100
@@ -61,6 +76,9 @@ protected:
 
 		reset_io_context_refs();
 		stop_all_timer(); //just in case, theoretically, timer TIMER_DELAY_CLOSE and TIMER_ASYNC_SHUTDOWN (used by tcp::socket_base) can left behind.
+#ifdef ASCS_HEARTBEAT_SCHEDULER
+		stop_heartbeat();
+#endif
 
 		stat.reset();
 		packer_->reset();
@@ -69,8 +87,14 @@ protected:
 #ifdef ASCS_PASSIVE_RECV
 		clear_reading();
 #endif
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+		consumer_state_ = consumer_state::HEALTHY;
+		drain_rate_ = enqueue_rate_ = 0;
+#endif
 #ifdef ASCS_SYNC_RECV
 		sr_status = sync_recv_status::NOT_REQUESTED;
+		sync_recv_msgs.clear();
+		sync_recv_num = 0;
 #endif
 		obsoleted_ = false;
 		dispatching = false;
@@ -80,10 +104,40 @@ protected:
 
 	void clear_buffer()
 	{
-#ifndef ASCS_DISPATCH_BATCH_MSG
+#ifdef ASCS_DISPATCH_SPAN_MSG
+		dispatching_msgs.clear();
+		dispatching_begin = 0;
+		dispatching_size_in_byte = 0;
+#elif !defined(ASCS_DISPATCH_BATCH_MSG)
 		dispatching_msg.clear();
 #endif
 		send_buffer.clear();
+#ifdef ASCS_SEND_STAGING
+		for (auto& item : staging_lanes)
+			item.clear();
+		for (auto& item : lane_owners)
+			item.id.store(std::thread::id(), std::memory_order_relaxed);
+		staged.store(false, std::memory_order_relaxed);
+#endif
+#ifdef ASCS_COALESCE_SEND_MSG
+		send_buffer.lock();
+		coalescing_slab.clear();
+		coalescing_size.store(0, std::memory_order_relaxed);
+		send_buffer.unlock();
+#endif
+#ifdef ASCS_CONFLATE_SEND_MSG
+		std::unique_lock<std::mutex> lock(conflation_mutex);
+		conflation_keys.clear();
+		conflation_msgs.clear();
+		conflation_num.store(0, std::memory_order_relaxed);
+		conflation_size_in_byte.store(0, std::memory_order_relaxed);
+		lock.unlock();
+#endif
+#ifdef ASCS_SPILL_SEND_BUFFER
+		std::unique_lock<std::mutex> spill_lock(spill_mutex);
+		reset_spill_file();
+		spill_lock.unlock();
+#endif
 		recv_buffer.clear();
 	}
 
@@ -154,9 +208,30 @@ public:
 protected:
 #endif
 #ifdef ASCS_ARBITRARY_SEND
-	void send_msg() {_send_msg();}
+	void send_msg() {if (!defer_sending()) _send_msg();}
+#else
+	//here we cannot use is_sending(), because we need memory fence
+	void send_msg() {if (!defer_sending() && is_ready() && 1 != sending.load(std::memory_order_acquire)) _send_msg();}
+#endif
+
+#ifdef ASCS_CONSOLIDATE_FLUSH
+	//flush messages deferred by the current handler batch right now, must be called before blocking (sync sending or waiting for the
+	// send buffer to become available), because the deferred flush only happens after the handler returns.
+	void flush_deferred_sending()
+	{
+		if (std::this_thread::get_id() == flush_deferring_thread.load(std::memory_order_relaxed) && flush_pending)
+		{
+			flush_pending = false;
+#ifdef ASCS_ARBITRARY_SEND
+			_send_msg();
+#else
+			if (is_ready() && 1 != sending.load(std::memory_order_acquire))
+				_send_msg();
+#endif
+		}
+	}
 #else
-	void send_msg() {if (is_ready() && 1 != sending.load(std::memory_order_acquire)) _send_msg();} //here we cannot use is_sending(), because we need memory fence
+	void flush_deferred_sending() {}
 #endif
 
 public:
@@ -164,9 +239,22 @@ public:
 	{
 		assert(interval > 0 && max_absence > 0);
 
+#ifdef ASCS_HEARTBEAT_SCHEDULER
+		hb_scheduler.add(hb_index, interval, make_handler_error(ASCS_COPY_ALL_AND_THIS(const boost::system::error_code& ec) {
+			if (!check_heartbeat(interval, max_absence))
+				stop_heartbeat();
+		}));
+#else
 		if (!is_timer(TIMER_HEARTBEAT_CHECK))
 			set_timer(TIMER_HEARTBEAT_CHECK, interval * 1000, ASCS_COPY_ALL_AND_THIS(tid id)->bool {return check_heartbeat(interval, max_absence);});
+#endif
 	}
+	//heartbeat will be stopped automatically when the link broke.
+#ifdef ASCS_HEARTBEAT_SCHEDULER
+	void stop_heartbeat() {hb_scheduler.remove(hb_index);}
+#else
+	void stop_heartbeat() {stop_timer(TIMER_HEARTBEAT_CHECK);}
+#endif
 
 	//interval's unit is second
 	//if macro ASCS_HEARTBEAT_INTERVAL been defined and is bigger than zero, start_heartbeat will be called automatically with interval equal to ASCS_HEARTBEAT_INTERVAL,
@@ -192,17 +280,46 @@ public:
 		return true;
 	}
 
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	//interval's unit is millisecond, the peer will be considered stuck if there're pending messages but no bytes been sent during
+	// max_stuck continuous intervals, see macro ASCS_SLOW_CONSUMER_CHECK for more details.
+	//the checking will be stopped automatically when the link broke.
+	void start_slow_consumer_check(unsigned interval = ASCS_SLOW_CONSUMER_CHECK_INTERVAL, unsigned max_stuck = ASCS_SLOW_CONSUMER_MAX_STUCK)
+	{
+		assert(interval > 0 && max_stuck > 0);
+
+		if (!is_timer(TIMER_SLOW_CONSUMER_CHECK))
+		{
+			last_send_byte_sum = stat.send_byte_sum;
+			last_pending_size_in_byte = backlog_size_in_byte();
+			stuck_num = 0;
+			set_timer(TIMER_SLOW_CONSUMER_CHECK, interval, ASCS_COPY_ALL_AND_THIS(tid id)->bool {return check_slow_consumer(interval, max_stuck);});
+		}
+	}
+	void stop_slow_consumer_check() {stop_timer(TIMER_SLOW_CONSUMER_CHECK);}
+
+	consumer_state get_consumer_state() const {return consumer_state_;}
+	//bytes per second, measured during the last interval of the slow consumer checking.
+	size_t drain_rate() const {return drain_rate_;}
+	size_t enqueue_rate() const {return enqueue_rate_;}
+#endif
+
 	bool is_sending() const {return 1 == sending.load(std::memory_order_relaxed);}
 	bool is_dispatching() const {return dispatching;}
 	bool is_recv_idle() const {return recv_idle_began;}
 
 	void send_buf_size(size_t size) {if (size > 0) send_buf_size_ = size;}
 	size_t send_buf_size() const {return send_buf_size_;}
-	float send_buf_usage() const {return (float) send_buffer.size_in_byte() / send_buf_size_;}
+	float send_buf_usage() const {return (float) pending_send_size_in_byte() / send_buf_size_;}
+#ifdef ASCS_SPILL_SEND_BUFFER
+	//messages spilled to disk are not counted in send_buf_usage, they don't occupy memory.
+	size_t spilled_send_size_in_byte() const {return spilled_size_in_byte;}
+#endif
 
 	void recv_buf_size(size_t size) {if (size > 0) recv_buf_size_ = size;}
 	size_t recv_buf_size() const {return recv_buf_size_;}
-	float recv_buf_usage() const {return (float) recv_buffer.size_in_byte() / recv_buf_size_;}
+	//with macro ASCS_DISPATCH_SPAN_MSG, messages which have been taken out of the recv buffer but not been handled are counted too.
+	float recv_buf_usage() const {return (float) pending_recv_size_in_byte() / recv_buf_size_;}
 
 	void msg_resuming_interval(unsigned interval) {msg_resuming_interval_ = interval;}
 	unsigned msg_resuming_interval() const {return msg_resuming_interval_;}
@@ -210,6 +327,40 @@ public:
 	void msg_handling_interval(size_t interval) {msg_handling_interval_ = interval;}
 	size_t msg_handling_interval() const {return msg_handling_interval_;}
 
+#ifdef ASCS_EXPIRE_SEND_MSG
+	//messages stayed in the send buffer longer than ttl milliseconds will be dropped rather than sent, 0 means never expire.
+	void send_msg_ttl(unsigned ttl) {send_msg_ttl_ = ttl;}
+	unsigned send_msg_ttl() const {return send_msg_ttl_;}
+#endif
+
+#ifdef ASCS_SEND_LINGER
+	//duration's unit is microsecond, 0 means don't linger, see macro ASCS_SEND_LINGER for more details.
+	void send_linger(unsigned duration, size_t size = ASCS_SEND_LINGER_SIZE) {send_linger_duration_ = duration; send_linger_size_ = size;}
+	unsigned send_linger_duration() const {return send_linger_duration_;}
+	size_t send_linger_size() const {return send_linger_size_;}
+
+	//send messages in the send buffer right now, regardless of the linger window.
+	void flush() {if (is_ready()) _send_msg();}
+#endif
+
+#if !defined(ASCS_DISPATCH_BATCH_MSG) && !defined(ASCS_DISPATCH_SPAN_MSG)
+	//handle at most num messages or duration microseconds (0 means no limitation, whichever comes first) in one dispatching before yielding the dispatch strand,
+	//with macro ASCS_ADAPTIVE_DISPATCH_BUDGET, num is the upper limit of the adaptive budget.
+	void dispatch_budget(size_t num, unsigned duration = 0)
+	{
+		if (num > 0)
+		{
+			dispatch_budget_num_ = num;
+#ifdef ASCS_ADAPTIVE_DISPATCH_BUDGET
+			cur_dispatch_budget_num = std::min(cur_dispatch_budget_num, num);
+#endif
+		}
+		dispatch_budget_duration_ = duration;
+	}
+	size_t dispatch_budget_num() const {return dispatch_budget_num_;}
+	unsigned dispatch_budget_duration() const {return dispatch_budget_duration_;}
+#endif
+
 	//in ascs, it's thread safe to access stat without mutex, because for a specific member of stat, ascs will never access it concurrently.
 	//but user can access stat out of ascs via get_statistic function, although user can only read it, there's still a potential risk (especially
 	// on 32 bit system, most likely, it will not be thread safe), so whether it's thread safe or not depends on std::chrono::system_clock::duration.
@@ -237,11 +388,12 @@ public:
 
 	//if you use can_overflow = true to invoke send_msg or send_native_msg, it will always succeed no matter the sending buffer is overflow or not,
 	//this can exhaust all virtual memory, please pay special attentions.
-	bool is_send_buffer_available() const {return send_buffer.size_in_byte() < send_buf_size_;}
+	//with macro ASCS_SEND_STAGING, messages in the staging lanes are counted too.
+	bool is_send_buffer_available() const {return pending_send_size_in_byte() < send_buf_size_;}
 
 	//if you define macro ASCS_PASSIVE_RECV and call recv_msg greedily, the receiving buffer may overflow, this can exhaust all virtual memory,
 	//to avoid this problem, call recv_msg only if is_recv_buffer_available() returns true.
-	bool is_recv_buffer_available() const {return recv_buffer.size_in_byte() < recv_buf_size_;}
+	bool is_recv_buffer_available() const {return pending_recv_size_in_byte() < recv_buf_size_;}
 
 	//don't use the packer but insert into send buffer directly
 	template<typename T> bool direct_send_msg(T&& msg, bool can_overflow = false, bool prior = false)
@@ -249,6 +401,35 @@ public:
 	bool direct_send_msg(std::list<InMsgType>& msg_can, bool can_overflow = false, bool prior = false)
 		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(msg_can, prior) : false;}
 
+#ifdef ASCS_CONFLATE_SEND_MSG
+	//don't use the packer but insert into the conflation queue, if a message with the same key is still pending (not been taken by the IO
+	// strand), it will be replaced in place, see macro ASCS_CONFLATE_SEND_MSG for more details.
+	template<typename T> bool direct_conflate_send_msg(uint_fast64_t key, T&& msg, bool can_overflow = false)
+	{
+		if (msg.empty())
+		{
+			unified_out::error_out(ASCS_LLF " found an empty message, please check your packer.", id());
+			return true; //see do_direct_send_msg for why returning true
+		}
+
+		auto size_in_byte = msg.size();
+		in_container_type temp_buffer;
+		temp_buffer.emplace_back(std::forward<T>(msg));
+		return do_conflate_send_msg(key, temp_buffer, size_in_byte, can_overflow);
+	}
+
+	bool direct_conflate_send_msg(uint_fast64_t key, std::list<InMsgType>& msg_can, bool can_overflow = false)
+	{
+		size_t size_in_byte = 0;
+		in_container_type temp_buffer;
+		ascs::do_something_to_all(msg_can, [&](InMsgType& msg) {size_in_byte += msg.size(); temp_buffer.emplace_back(std::move(msg));});
+#ifdef ASCS_EXPIRE_SEND_MSG
+		unify_queued_time(temp_buffer);
+#endif
+		return do_conflate_send_msg(key, temp_buffer, size_in_byte, can_overflow);
+	}
+#endif
+
 #ifdef ASCS_SYNC_SEND
 	//don't use the packer but insert into send buffer directly, then wait the sending to finish, unit of the duration is millisecond, 0 means wait infinitely
 	template<typename T> sync_call_result direct_sync_send_msg(T&& msg, unsigned duration = 0, bool can_overflow = false, bool prior = false)
@@ -258,25 +439,31 @@ public:
 #endif
 
 #ifdef ASCS_SYNC_RECV
-	sync_call_result sync_recv_msg(std::list<OutMsgType>& msg_can, unsigned duration = 0) //unit of the duration is millisecond, 0 means wait infinitely
+	//unit of the duration is millisecond, 0 means wait infinitely
+	sync_call_result sync_recv_msg(std::list<OutMsgType>& msg_can, unsigned duration = 0) {return sync_recv_msg(msg_can, -1, 1, duration);}
+	//wait until at least min_num messages been received, at most max_num messages will be taken, the rest will be dispatched as usual.
+	//messages are collected across receivings without blocking the IO strand, and if timed out or the link broken, msg_can will get the
+	// messages collected so far (less than min_num).
+	sync_call_result sync_recv_msg(std::list<OutMsgType>& msg_can, size_t max_num, size_t min_num, unsigned duration = 0)
 	{
-		if (stopped())
+		assert(min_num > 0 && max_num >= min_num);
+		if (stopped() || 0 == min_num || max_num < min_num)
 			return sync_call_result::NOT_APPLICABLE;
 
 		std::unique_lock<std::mutex> lock(sync_recv_mutex);
 		if (sync_recv_status::NOT_REQUESTED != sr_status)
 			return sync_call_result::DUPLICATE;
 
+		sr_max_num = max_num;
+		sr_min_num = min_num;
+		sr_status.store(sync_recv_status::REQUESTED, std::memory_order_release);
 #ifdef ASCS_PASSIVE_RECV
 		recv_msg();
 #endif
-		sr_status = sync_recv_status::REQUESTED;
 		auto re = sync_recv_waiting(lock, duration);
-		if (sync_call_result::SUCCESS == re)
-			msg_can.splice(std::end(msg_can), temp_msg_can);
-
+		msg_can.splice(std::end(msg_can), sync_recv_msgs);
+		sync_recv_num = 0;
 		sr_status = sync_recv_status::NOT_REQUESTED;
-		sync_recv_cv.notify_one();
 
 		return re;
 	}
@@ -312,6 +499,18 @@ protected:
 		return true;
 	}
 	virtual bool on_heartbeat_error() = 0; //heartbeat timed out, return true to continue heartbeat function (useful for UDP)
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	//the policy of slow consumers, for example, switch to conflate_send_msg (macro ASCS_CONFLATE_SEND_MSG) or lower the priority of
+	// this socket in your broadcasting when it's lagging, disconnect it when it's stuck (tcp::server_socket_base's behavior).
+	//return false to stop the slow consumer checking.
+	virtual bool on_consumer_state_change(consumer_state prev_state, consumer_state state)
+	{
+		static const char* const names[] = {"healthy", "lagging", "stuck"};
+		unified_out::info_out(ASCS_LLF " consumer state changed from %s to %s (drain rate: " ASCS_SF ", enqueue rate: " ASCS_SF ").",
+			id(), names[prev_state], names[state], drain_rate_.load(), enqueue_rate_.load());
+		return true;
+	}
+#endif
 
 	//if ASCS_DELAY_CLOSE is equal to zero, in this callback, socket guarantee that there's no any other async call associated it,
 	// include user timers(created by set_timer()) and user async calls(started via post(), dispatch() or defer()), this means you can clean up any resource
@@ -335,7 +534,18 @@ protected:
 		return 1;
 	}
 #endif
-#ifdef ASCS_DISPATCH_BATCH_MSG
+#ifdef ASCS_DISPATCH_SPAN_MSG
+	//msg_span is a contiguous view of the messages waiting for dispatching (held in a vector owned by this socket), return the number of
+	// messages at the front of msg_span been handled, the rest will be re-dispatched asynchronously (after msg_handling_interval_ milliseconds
+	// if nothing been handled). do not hold msg_span for further usage, but you can swap or move its messages out.
+	virtual size_t on_msg_handle(obj_span<out_msg> msg_span)
+	{
+		ascs::do_something_to_all(msg_span, [this](OutMsgType& msg) {
+			unified_out::debug_out(ASCS_LLF " recv(" ASCS_SF "): %s", id(), msg.size(), msg.data());
+		});
+		return msg_span.size();
+	}
+#elif defined(ASCS_DISPATCH_BATCH_MSG)
 	//return positive value if handled some messages (include all messages), if some msg left behind, socket will re-dispatch them asynchronously
 	//notice: using inconstant reference is for the ability of swapping
 	virtual size_t on_msg_handle(out_queue_type& msg_can)
@@ -365,13 +575,21 @@ protected:
 	virtual void on_all_msg_send(InMsgType& msg) = 0;
 #endif
 
+#if defined(ASCS_SHRINK_SEND_BUFFER) || defined(ASCS_EXPIRE_SEND_MSG)
+	//messages discarded by shrink_send_buffer (in the thread calling send_msg) or expired (in the IO strand), see macro ASCS_SHRINK_SEND_BUFFER
+	// and ASCS_EXPIRE_SEND_MSG for more details.
+	virtual void on_msg_discard(in_container_type& msg_can) {}
+#endif
+
 	//return true means send buffer becomes available
 #ifdef ASCS_SHRINK_SEND_BUFFER
 	virtual size_t calc_shrink_size(size_t current_size) {return current_size / 3;}
-	virtual void on_msg_discard(in_container_type& msg_can) {}
 
 	bool shrink_send_buffer()
 	{
+#ifdef ASCS_SEND_STAGING
+		harvest_staged_msgs(); //only the send buffer can be shrunk
+#endif
 		send_buffer.lock();
 		auto size = send_buffer.size_in_byte();
 		if (size < send_buf_size_)
@@ -392,6 +610,8 @@ protected:
 		on_msg_discard(msg_can);
 		return true;
 	}
+#elif defined(ASCS_SPILL_SEND_BUFFER)
+	bool shrink_send_buffer() const {return spillable::value || is_send_buffer_available();} //overflowed messages will be spilled
 #else
 	bool shrink_send_buffer() const {return is_send_buffer_available();}
 #endif
@@ -421,6 +641,9 @@ protected:
 		sync_recv_cv.notify_all();
 #endif
 		stop_all_timer();
+#ifdef ASCS_HEARTBEAT_SCHEDULER
+		stop_heartbeat();
+#endif
 
 		if (lowest_layer().is_open())
 		{
@@ -449,13 +672,14 @@ protected:
 	void handle_error()
 	{
 #ifdef ASCS_SYNC_RECV
-		std::unique_lock<std::mutex> lock(sync_recv_mutex);
-		if (sync_recv_status::REQUESTED == sr_status)
+		if (sync_recv_status::REQUESTED == sr_status.load(std::memory_order_acquire))
 		{
-			sr_status = sync_recv_status::RESPONDED_FAILURE;
-			sync_recv_cv.notify_one();
-
-			sync_recv_cv.wait(lock, [this]() {return !started_ || sync_recv_status::RESPONDED_FAILURE != sr_status;});
+			std::lock_guard<std::mutex> lock(sync_recv_mutex);
+			if (sync_recv_status::REQUESTED == sr_status)
+			{
+				sr_status = sync_recv_status::RESPONDED_FAILURE;
+				sync_recv_cv.notify_one();
+			}
 		}
 #endif
 	}
@@ -467,19 +691,31 @@ protected:
 		stat.recv_msg_sum += size;
 		stat.recv_byte_sum += size_in_byte;
 #ifdef ASCS_SYNC_RECV
-		std::unique_lock<std::mutex> lock(sync_recv_mutex);
-		if (sync_recv_status::REQUESTED == sr_status)
+		if (sync_recv_status::REQUESTED == sr_status.load(std::memory_order_acquire)) //only touch the mutex if sync_recv_msg is waiting
 		{
-			sr_status = sync_recv_status::RESPONDED;
-			sync_recv_cv.notify_one();
+			std::unique_lock<std::mutex> lock(sync_recv_mutex);
+			if (sync_recv_status::REQUESTED == sr_status)
+			{
+				auto num = std::min(sr_max_num - sync_recv_num, size);
+				sync_recv_msgs.splice(std::end(sync_recv_msgs), temp_msg_can, std::begin(temp_msg_can), std::next(std::begin(temp_msg_can), num));
+				sync_recv_num += num;
+				size_in_byte = 0; //to re-calculate size_in_byte
 
-			sync_recv_cv.wait(lock, [this]() {return !started_ || sync_recv_status::RESPONDED != sr_status;});
-			if (sync_recv_status::RESPONDED == sr_status) //eliminate race condition on temp_msg_can with sync_recv_msg
-				return false;
-			else if (temp_msg_can.empty())
+				if (sync_recv_num >= sr_min_num)
+				{
+					sr_status = sync_recv_status::RESPONDED;
+					sync_recv_cv.notify_one();
+				}
+#ifdef ASCS_PASSIVE_RECV
+				else if (temp_msg_can.empty())
+					return true; //keep receiving until the request been satisfied
+#endif
+			}
+			lock.unlock();
+
+			if (temp_msg_can.empty())
 				return handled_msg(); //sync_recv_msg() has consumed temp_msg_can
 		}
-		lock.unlock();
 #endif
 		auto empty = temp_msg_can.empty();
 #ifdef ASCS_SYNC_DISPATCH
@@ -488,6 +724,9 @@ protected:
 #endif
 		{
 			auto_duration dur(stat.handle_time_sum);
+#ifdef ASCS_CONSOLIDATE_FLUSH
+			flush_deferrer deferrer(*this);
+#endif
 			if (on_msg(temp_msg_can) > 0)
 			{
 				size_in_byte = 0; //to re-calculate size_in_byte
@@ -519,8 +758,20 @@ protected:
 	{
 		if (msg.empty())
 			unified_out::error_out(ASCS_LLF " found an empty message, please check your packer.", id());
-		else if (prior ? send_buffer.enqueue_front(std::forward<T>(msg)) : send_buffer.enqueue(std::forward<T>(msg)))
-			send_msg();
+		else
+		{
+#ifdef ASCS_SPILL_SEND_BUFFER
+			auto re = prior ? NOT_SPILLED : spill_send_msgs(&msg, &msg + 1);
+			if (REFUSED == re)
+				return false;
+			else if (SPILLED == re)
+			{
+				send_msg();
+				return true;
+			}
+#endif
+			enqueue_send_msg(std::forward<T>(msg), prior);
+		}
 
 		//even if we meet an empty message (because of too big message or insufficient memory, most likely), we still return true, why?
 		//please think about the function safe_send_(native_)msg, if we keep returning false, it will enter a dead loop.
@@ -533,11 +784,66 @@ protected:
 		size_t size_in_byte = 0;
 		in_container_type temp_buffer;
 		ascs::do_something_to_all(msg_can, [&](InMsgType& msg) {size_in_byte += msg.size(); temp_buffer.emplace_back(std::move(msg));});
-		prior ? send_buffer.move_items_in_front(temp_buffer, size_in_byte) : send_buffer.move_items_in(temp_buffer, size_in_byte);
-		send_msg();
+#ifdef ASCS_SPILL_SEND_BUFFER
+		auto re = prior ? NOT_SPILLED : spill_send_msgs(std::begin(temp_buffer), std::end(temp_buffer));
+		if (REFUSED == re)
+		{
+			//give messages back to the caller
+			auto iter = std::begin(msg_can);
+			ascs::do_something_to_all(temp_buffer, [&](in_msg& msg) {iter++->swap(msg);});
+			return false;
+		}
+		else if (SPILLED == re)
+		{
+			send_msg();
+			return true;
+		}
+#endif
+#ifdef ASCS_EXPIRE_SEND_MSG
+		unify_queued_time(temp_buffer);
+#endif
+		move_send_msgs_in(temp_buffer, size_in_byte, prior);
+
+		return true;
+	}
+
+#ifdef ASCS_COALESCE_SEND_MSG
+	//pack a small message straight into the slab, return false if the message is not small enough or the packer doesn't support
+	// appending (i_packer::append_msg), then the caller must send it as usual, see macro ASCS_COALESCE_SEND_MSG for more details.
+	bool coalesce_send_msg(const char* const pstr[], const size_t len[], size_t num, bool native)
+	{
+		if (nullptr == pstr || nullptr == len)
+			return false;
+#ifdef ASCS_SPILL_SEND_BUFFER
+		else if (should_spill())
+			return false;
+#endif
+
+		size_t size_in_byte = 0;
+		for (size_t i = 0; i < num; ++i)
+			if (nullptr != pstr[i])
+				size_in_byte += len[i];
+		if (size_in_byte > ASCS_COALESCE_MSG_SIZE)
+			return false;
 
+		{
+			typename in_queue_type::lock_guard lock(send_buffer);
+			auto_duration dur(stat.pack_time_sum);
+			if (!packer_->append_msg(coalescing_slab, pstr, len, num, native))
+				return false;
+			dur.end();
+
+			++stat.send_coalesced_msg_sum;
+			if (coalescing_slab.size() >= ASCS_COALESCE_SLAB_SIZE)
+				flush_coalescing_slab();
+			else
+				coalescing_size.store(coalescing_slab.size(), std::memory_order_relaxed);
+		}
+
+		send_msg();
 		return true;
 	}
+#endif
 
 #ifdef ASCS_SYNC_SEND
 	template<typename T> sync_call_result do_direct_sync_send_msg(T&& msg, unsigned duration = 0, bool prior = false)
@@ -550,14 +856,14 @@ protected:
 			return sync_call_result::SUCCESS;
 		}
 
-		auto unused = in_msg(std::forward<T>(msg), true);
-		auto p = unused.p;
-		auto f = p->get_future();
-		if (!(prior ? send_buffer.enqueue_front(std::move(unused)) : send_buffer.enqueue(std::move(unused))))
+		auto unused = in_msg(std::forward<T>(msg));
+		unused.p = sync_send_slots->acquire();
+		auto waiter = unused.p.get_waiter();
+		if (!enqueue_send_msg(std::move(unused), prior))
 			return sync_call_result::NOT_APPLICABLE;
 
-		send_msg();
-		return 0 == duration || std::future_status::ready == f.wait_for(std::chrono::milliseconds(duration)) ? f.get() : sync_call_result::TIMEOUT;
+		flush_deferred_sending(); //otherwise we wait for the flush which happens after ourselves
+		return waiter->wait(duration);
 	}
 
 	sync_call_result do_direct_sync_send_msg(std::list<InMsgType>& msg_can, unsigned duration = 0, bool prior = false)
@@ -570,18 +876,570 @@ protected:
 		size_t size_in_byte = 0;
 		in_container_type temp_buffer;
 		ascs::do_something_to_all(msg_can, [&](InMsgType& msg) {size_in_byte += msg.size(); temp_buffer.emplace_back(std::move(msg));});
+#ifdef ASCS_EXPIRE_SEND_MSG
+		unify_queued_time(temp_buffer);
+#endif
 
-		temp_buffer.back().check_and_create_promise(true);
-		auto p = temp_buffer.back().p;
-		auto f = p->get_future();
-		prior ? send_buffer.move_items_in_front(temp_buffer, size_in_byte) : send_buffer.move_items_in(temp_buffer, size_in_byte);
+		temp_buffer.back().p = sync_send_slots->acquire();
+		auto waiter = temp_buffer.back().p.get_waiter();
+		move_send_msgs_in(temp_buffer, size_in_byte, prior);
 
-		send_msg();
-		return 0 == duration || std::future_status::ready == f.wait_for(std::chrono::milliseconds(duration)) ? f.get() : sync_call_result::TIMEOUT;
+		flush_deferred_sending(); //otherwise we wait for the flush which happens after ourselves
+		return waiter->wait(duration);
+	}
+#endif
+
+	//subclasses must use this function instead of send_buffer.empty() in the IO strand, because with macro ASCS_SEND_STAGING,
+	// messages in the staging lanes will be harvested into the send buffer first.
+	//batch_size is the size of one sending batch (reader_writer::batch_msg_send_size), 0 means unknown (then asio's default transfer size).
+	bool is_send_buffer_empty(size_t batch_size = 0)
+	{
+		if (0 == batch_size)
+			batch_size = boost::asio::detail::default_max_transfer_size;
+#ifdef ASCS_SEND_STAGING
+		harvest_staged_msgs();
+#endif
+#ifdef ASCS_COALESCE_SEND_MSG
+		harvest_coalesced_msgs(batch_size);
+#endif
+#ifdef ASCS_CONFLATE_SEND_MSG
+		harvest_conflated_msgs(batch_size);
+#endif
+#ifdef ASCS_SPILL_SEND_BUFFER
+		if (send_buffer.empty())
+			drain_spilled_msgs(spillable());
+#endif
+		return send_buffer.empty();
+	}
+
+	//must be called in the IO strand, expired messages will be dropped.
+	bool try_dequeue_send_msg(in_msg& msg)
+	{
+#ifdef ASCS_EXPIRE_SEND_MSG
+		while (send_buffer.try_dequeue(msg))
+			if (!is_send_msg_expired(msg, std::chrono::steady_clock::now(), send_msg_ttl_))
+				return true;
+			else
+			{
+				++stat.send_expired_msg_sum;
+				in_container_type msg_can;
+				msg_can.emplace_back(std::move(msg));
+				on_msg_discard(msg_can);
+			}
+
+		return false;
+#else
+		return send_buffer.try_dequeue(msg);
+#endif
+	}
+
+#ifdef ASCS_EXPIRE_SEND_MSG
+	//a packer can split one message into several (like head and body), they are queued together and must be expired together, so mark them
+	// with the same batch id, the first message of the batch decides the fate of all of them.
+	static void unify_queued_time(in_container_type& msg_can)
+	{
+		static std::atomic_uint_fast64_t next_batch_id(0);
+		if (msg_can.size() > 1)
+		{
+			auto batch_id = ++next_batch_id;
+			auto queued_time = msg_can.front().queued_time;
+			ascs::do_something_to_all(msg_can, [&](in_msg& msg) {msg.queued_time = queued_time; msg.batch_id = batch_id;});
+		}
+	}
+
+	//must be called in the IO strand and in the sending order, because a batch (see unify_queued_time) can span more than one sending.
+	bool is_send_msg_expired(const in_msg& msg, const std::chrono::steady_clock::time_point& now, unsigned ttl)
+	{
+		if (0 != msg.batch_id && msg.batch_id == last_batch_id)
+			return last_batch_expired;
+
+		auto expired = 0 != ttl && now - msg.queued_time > std::chrono::milliseconds(ttl);
+		if (0 != msg.batch_id) //the first message of a batch
+		{
+			last_batch_id = msg.batch_id;
+			last_batch_expired = expired;
+		}
+
+		return expired;
+	}
+
+	//must be called in the IO strand, move expired messages out of msg_can and call on_msg_discard with them.
+	void drop_expired_send_msgs(in_container_type& msg_can)
+	{
+		unsigned ttl = send_msg_ttl_;
+		if (0 == ttl)
+		{
+			if (!msg_can.empty()) //the rest of this batch will not expire either, even if the ttl is changed before they're sent
+			{
+				last_batch_id = msg_can.back().batch_id;
+				last_batch_expired = false;
+			}
+			return;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		in_container_type expired_msgs;
+		for (auto iter = std::begin(msg_can); iter != std::end(msg_can);)
+		{
+			auto next = std::next(iter);
+			if (is_send_msg_expired(*iter, now, ttl))
+			{
+				++stat.send_expired_msg_sum;
+				expired_msgs.splice(std::end(expired_msgs), msg_can, iter, next);
+			}
+			iter = next;
+		}
+
+		if (!expired_msgs.empty())
+			on_msg_discard(expired_msgs);
 	}
 #endif
 
 private:
+	//enqueue messages and then trigger sending.
+	template<typename T> bool enqueue_send_msg(T&& msg, bool prior)
+	{
+		if (prior)
+		{
+			if (!send_buffer.enqueue_front(std::forward<T>(msg)))
+				return false;
+		}
+		else
+#ifdef ASCS_SEND_STAGING
+		{
+			auto lane = staging_lane();
+			if (nullptr != lane && lane->enqueue(std::forward<T>(msg))) //msg will not be moved if the lane is full
+			{
+				trigger_staged_sending();
+				return true;
+			}
+
+			typename in_queue_type::lock_guard lock(send_buffer);
+			if (nullptr != lane)
+				harvest_staging_lane(*lane); //keep the order
+			if (!send_buffer.enqueue_(std::forward<T>(msg)))
+				return false;
+		}
+#elif defined(ASCS_COALESCE_SEND_MSG)
+		{
+			typename in_queue_type::lock_guard lock(send_buffer);
+			flush_coalescing_slab(); //keep the order
+			if (!send_buffer.enqueue_(std::forward<T>(msg)))
+				return false;
+		}
+#else
+		if (!send_buffer.enqueue(std::forward<T>(msg)))
+			return false;
+#endif
+
+		send_msg();
+		return true;
+	}
+
+	void move_send_msgs_in(in_container_type& msg_can, size_t size_in_byte, bool prior)
+	{
+		if (prior)
+			send_buffer.move_items_in_front(msg_can, size_in_byte);
+		else
+#ifdef ASCS_SEND_STAGING
+		{
+			auto lane = staging_lane();
+			if (nullptr != lane)
+				for (; !msg_can.empty() && lane->enqueue(std::move(msg_can.front())); msg_can.pop_front())
+					;
+			if (msg_can.empty())
+			{
+				trigger_staged_sending();
+				return;
+			}
+
+			typename in_queue_type::lock_guard lock(send_buffer);
+			if (nullptr != lane)
+				harvest_staging_lane(*lane); //keep the order
+			send_buffer.move_items_in_(msg_can);
+		}
+#elif defined(ASCS_COALESCE_SEND_MSG)
+		{
+			typename in_queue_type::lock_guard lock(send_buffer);
+			flush_coalescing_slab(); //keep the order
+			send_buffer.move_items_in_(msg_can, size_in_byte);
+		}
+#else
+			send_buffer.move_items_in(msg_can, size_in_byte);
+#endif
+
+		send_msg();
+	}
+
+#ifdef ASCS_SPILL_SEND_BUFFER
+	//only sockets whose in message type is the packer's message type (tcp sockets) can spill, because messages are restored by the packer.
+	typedef std::is_same<InMsgType, typename Packer::msg_type> spillable;
+
+	//once spilled, all subsequent messages must be spilled too until the spill file been drained, otherwise the order will be broken.
+	bool should_spill() const {return spillable::value && (spilled_size_in_byte > 0 || !is_send_buffer_available());}
+
+	//all or nothing, NOT_SPILLED means the messages should go to the send buffer, REFUSED means they cannot be spilled but earlier messages
+	// have been spilled, then they must not go to the send buffer either (which will be sent before the spilled ones), refuse them instead.
+	enum spill_result {SPILLED, NOT_SPILLED, REFUSED};
+	template<typename Iter> spill_result spill_send_msgs(Iter begin, Iter end)
+	{
+		if (!should_spill())
+			return NOT_SPILLED;
+
+		std::lock_guard<std::mutex> lock(spill_mutex);
+		if (!should_spill())
+			return NOT_SPILLED;
+		else if ((!spill_file && !open_spill_file()) || 0 != fsetpos(spill_file.get(), &spill_write_pos))
+			return spilled_size_in_byte > 0 ? REFUSED : NOT_SPILLED;
+
+		size_t size_in_byte = 0, num = 0;
+		auto iter = begin;
+		for (size_t len; iter != end; ++iter, ++num, size_in_byte += len)
+			if (len = iter->size(), 1 != fwrite(&len, sizeof(size_t), 1, spill_file.get()) || len != fwrite(iter->data(), 1, len, spill_file.get()))
+				break;
+
+		//flush now, otherwise failures will only be found at draining time, when the messages have been lost
+		if (iter != end || 0 != fflush(spill_file.get()))
+		{
+			clearerr(spill_file.get()); //spill_write_pos not changed, so written data will be overwritten later
+			if (spilled_size_in_byte > 0)
+			{
+				unified_out::error_out(ASCS_LLF " failed to write the spill file, messages are refused.", id());
+				return REFUSED;
+			}
+
+			unified_out::error_out(ASCS_LLF " failed to write the spill file, messages will stay in the send buffer.", id());
+			return NOT_SPILLED;
+		}
+
+		fgetpos(spill_file.get(), &spill_write_pos);
+		spilled_size_in_byte += size_in_byte;
+		stat.send_spilled_msg_sum += num;
+		return SPILLED;
+	}
+
+	void drain_spilled_msgs(std::false_type) {}
+	//drain at most half of the send buffer each time, so producers can see the send buffer available again (and stop spilling) after
+	// the peer caught up.
+	void drain_spilled_msgs(std::true_type)
+	{
+		if (0 == spilled_size_in_byte)
+			return;
+
+		std::lock_guard<std::mutex> lock(spill_mutex);
+		if (0 == spilled_size_in_byte || 0 != fsetpos(spill_file.get(), &spill_read_pos))
+			return;
+
+		size_t size_in_byte = 0, drained_size_in_byte = 0;
+		in_container_type temp_buffer;
+		std::vector<char> buff;
+		while (drained_size_in_byte < spilled_size_in_byte && size_in_byte < send_buf_size_ / 2)
+		{
+			size_t len;
+			if (1 != fread(&len, sizeof(size_t), 1, spill_file.get()) || (buff.resize(len), len != fread(buff.data(), 1, len, spill_file.get())))
+			{
+				unified_out::error_out(ASCS_LLF " failed to read the spill file, " ASCS_SF " bytes spilled messages are lost.", id(),
+					spilled_size_in_byte - drained_size_in_byte);
+				drained_size_in_byte = spilled_size_in_byte;
+				break;
+			}
+			drained_size_in_byte += len;
+
+			const char* pstr = buff.data();
+			auto msg = packer_->pack_msg(&pstr, &len, 1, true);
+			size_in_byte += msg.size();
+			temp_buffer.emplace_back(std::move(msg));
+		}
+
+		//move messages into the send buffer before decreasing spilled_size_in_byte, see should_spill
+		send_buffer.move_items_in(temp_buffer, size_in_byte);
+		if (drained_size_in_byte < spilled_size_in_byte)
+		{
+			fgetpos(spill_file.get(), &spill_read_pos);
+			spilled_size_in_byte -= drained_size_in_byte;
+		}
+		else
+			reset_spill_file();
+	}
+
+	bool open_spill_file() //spill_mutex must be held
+	{
+		spill_file.reset(std::tmpfile());
+		if (!spill_file)
+		{
+			unified_out::error_out(ASCS_LLF " failed to create the spill file, messages will stay in the send buffer.", id());
+			return false;
+		}
+
+		reset_spill_file();
+		return true;
+	}
+
+	void reset_spill_file() //spill_mutex must be held, reuse the spill file from its beginning
+	{
+		if (spill_file)
+		{
+			rewind(spill_file.get());
+			fgetpos(spill_file.get(), &spill_read_pos);
+			spill_write_pos = spill_read_pos;
+		}
+		spilled_size_in_byte = 0;
+	}
+#endif
+
+#ifdef ASCS_CONFLATE_SEND_MSG
+	bool do_conflate_send_msg(uint_fast64_t key, in_container_type& msg_can, size_t size_in_byte, bool can_overflow)
+	{
+		std::unique_lock<std::mutex> lock(conflation_mutex);
+		auto iter = conflation_msgs.find(key);
+		if (std::end(conflation_msgs) != iter)
+		{
+			conflation_size_in_byte.fetch_sub(iter->second.size_in_byte, std::memory_order_relaxed);
+			++iter->second.replaced_num; //will be counted by the IO strand
+		}
+		else if (!can_overflow && !is_send_buffer_available()) //replacing never makes the send buffer grow (too much)
+			return false;
+		else
+		{
+			iter = conflation_msgs.emplace(key, conflated_msg()).first;
+			conflation_keys.push_back(key);
+			++conflation_num;
+		}
+
+		iter->second.msgs.swap(msg_can); //replaced messages will be freed out of the mutex
+		iter->second.size_in_byte = size_in_byte;
+		conflation_size_in_byte.fetch_add(size_in_byte, std::memory_order_relaxed);
+		lock.unlock();
+
+		send_msg();
+		return true;
+	}
+
+	//keep at most one batch in the send buffer, the rest stay conflatable.
+	void harvest_conflated_msgs(size_t batch_size)
+	{
+		if (0 == conflation_num || send_buffer.size_in_byte() >= batch_size)
+			return;
+
+		size_t size_in_byte = 0, num = 0, replaced_num = 0;
+		in_container_type temp_buffer;
+		std::unique_lock<std::mutex> lock(conflation_mutex);
+		while (!conflation_keys.empty() && send_buffer.size_in_byte() + size_in_byte < batch_size)
+		{
+			auto iter = conflation_msgs.find(conflation_keys.front());
+			assert(std::end(conflation_msgs) != iter);
+
+			size_in_byte += iter->second.size_in_byte;
+			replaced_num += iter->second.replaced_num;
+			temp_buffer.splice(std::end(temp_buffer), iter->second.msgs);
+			conflation_msgs.erase(iter);
+			conflation_keys.pop_front();
+			++num;
+		}
+		conflation_num -= num;
+		conflation_size_in_byte.fetch_sub(size_in_byte, std::memory_order_relaxed);
+		lock.unlock();
+
+		stat.send_conflated_msg_sum += replaced_num;
+		send_buffer.move_items_in(temp_buffer, size_in_byte);
+	}
+#endif
+
+#ifdef ASCS_COALESCE_SEND_MSG
+	//while the send buffer holds at least one batch, leave the slab to coalesce more messages.
+	void harvest_coalesced_msgs(size_t batch_size)
+	{
+		if (coalescable::value && send_buffer.size_in_byte() < batch_size)
+		{
+			typename in_queue_type::lock_guard lock(send_buffer);
+			flush_coalescing_slab();
+		}
+	}
+
+	//only sockets whose in message type is the packer's message type (tcp sockets) can coalesce, slabs are packed messages.
+	typedef std::is_same<InMsgType, typename Packer::msg_type> coalescable;
+
+	void flush_coalescing_slab() {flush_coalescing_slab(coalescable());} //the send buffer must be locked
+	void flush_coalescing_slab(std::false_type) {}
+	void flush_coalescing_slab(std::true_type)
+	{
+		if (!coalescing_slab.empty())
+		{
+			send_buffer.enqueue_(std::move(coalescing_slab));
+			coalescing_slab.clear(); //the state of a moved-from object is unspecified
+			reserve_slab(coalescing_slab, 0);
+			coalescing_size.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	//the next slab will be filled up soon, allocate it at once rather than growing it step by step.
+	template<typename T> static auto reserve_slab(T& slab, int) -> decltype(slab.reserve(0), void()) {slab.reserve(ASCS_COALESCE_SLAB_SIZE);}
+	template<typename T> static void reserve_slab(T& slab, ...) {}
+#endif
+
+#ifdef ASCS_SEND_STAGING
+	//a single producer single consumer ring, the producer is the thread which owns the lane, and the consumer is whoever holds the lock of
+	// the send buffer (the IO strand, shrink_send_buffer and the owner itself when the lane is full).
+	struct staging_lane_type
+	{
+		template<typename T> bool enqueue(T&& msg)
+		{
+			auto t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) >= msgs.size())
+				return false;
+
+			auto size = msg.size();
+			msgs[t % msgs.size()] = in_msg(std::forward<T>(msg));
+			size_in_byte.fetch_add(size, std::memory_order_relaxed);
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		void clear()
+		{
+			for (auto& item : msgs)
+				item.clear();
+			head.store(0, std::memory_order_relaxed);
+			tail.store(0, std::memory_order_relaxed);
+			size_in_byte.store(0, std::memory_order_relaxed);
+		}
+
+		char padding1[ASCS_SEND_STAGING_PADDING_SIZE]; //keep lanes in different cache lines, see ASCS_SEND_STAGING_PADDING_SIZE
+		std::atomic_size_t head{0}; //written by the consumer
+		char padding2[ASCS_SEND_STAGING_PADDING_SIZE];
+		std::atomic_size_t tail{0}, size_in_byte{0}; //written by the producer (size_in_byte by the consumer too)
+		std::array<in_msg, ASCS_SEND_STAGING_LANE_SIZE> msgs;
+	};
+
+	//each thread claims a lane at its first sending and sticks to it, so messages from the same thread keep their order, if all lanes
+	// have been claimed by other threads, return nullptr.
+	staging_lane_type* staging_lane()
+	{
+		auto id = std::this_thread::get_id();
+		for (size_t i = 0; i < lane_owners.size(); ++i)
+			if (id == lane_owners[i].id.load(std::memory_order_relaxed))
+				return &staging_lanes[i];
+
+		for (size_t i = 0; i < lane_owners.size(); ++i)
+		{
+			auto free_id = std::thread::id();
+			if (lane_owners[i].id.compare_exchange_strong(free_id, id, std::memory_order_relaxed))
+				return &staging_lanes[i];
+		}
+
+		return nullptr;
+	}
+
+	//only the producer which staged the first message since the last harvesting triggers sending, the others rely on it.
+	void trigger_staged_sending() {if (!staged.exchange(true)) send_msg();}
+
+	//the send buffer is locked during the whole harvesting, so concurrent harvesters (for example, shrink_send_buffer) cannot reorder messages.
+	void harvest_staged_msgs()
+	{
+		staged.exchange(false); //synchronize with trigger_staged_sending
+		typename in_queue_type::lock_guard lock(send_buffer);
+		for (auto& item : staging_lanes)
+			harvest_staging_lane(item);
+	}
+
+	//the send buffer must be locked
+	void harvest_staging_lane(staging_lane_type& lane)
+	{
+		auto h = lane.head.load(std::memory_order_relaxed), t = lane.tail.load(std::memory_order_acquire);
+		if (h == t)
+			return;
+
+		size_t size_in_byte = 0;
+		in_container_type temp_buffer;
+		for (; h != t; ++h)
+		{
+			auto& msg = lane.msgs[h % lane.msgs.size()];
+			size_in_byte += msg.size();
+			temp_buffer.emplace_back(std::move(msg));
+			msg.clear();
+		}
+		lane.head.store(t, std::memory_order_release);
+		lane.size_in_byte.fetch_sub(size_in_byte, std::memory_order_relaxed);
+
+		send_buffer.move_items_in_(temp_buffer, size_in_byte);
+	}
+#endif
+
+#ifdef ASCS_DISPATCH_SPAN_MSG
+	size_t pending_recv_size_in_byte() const {return recv_buffer.size_in_byte() + dispatching_size_in_byte.load(std::memory_order_relaxed);}
+#else
+	size_t pending_recv_size_in_byte() const {return recv_buffer.size_in_byte();}
+#endif
+
+	size_t pending_send_size_in_byte() const
+	{
+		auto size_in_byte = send_buffer.size_in_byte();
+#ifdef ASCS_SEND_STAGING
+		for (auto& item : staging_lanes)
+			size_in_byte += item.size_in_byte.load(std::memory_order_relaxed);
+#endif
+#ifdef ASCS_CONFLATE_SEND_MSG
+		size_in_byte += conflation_size_in_byte.load(std::memory_order_relaxed);
+#endif
+#ifdef ASCS_COALESCE_SEND_MSG
+		size_in_byte += coalescing_size.load(std::memory_order_relaxed);
+#endif
+
+		return size_in_byte;
+	}
+
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	size_t backlog_size_in_byte() const
+	{
+#ifdef ASCS_SPILL_SEND_BUFFER
+		return pending_send_size_in_byte() + spilled_size_in_byte;
+#else
+		return pending_send_size_in_byte();
+#endif
+	}
+
+	//drained bytes come from statistic::send_byte_sum, enqueued bytes are deduced from drained bytes and the change of the backlog.
+	bool check_slow_consumer(unsigned interval, unsigned max_stuck)
+	{
+		if (!is_ready())
+			return true;
+
+		auto pending_size_in_byte = backlog_size_in_byte();
+		auto drained_size_in_byte = (size_t) (stat.send_byte_sum - last_send_byte_sum);
+		//discarded messages (ASCS_SHRINK_SEND_BUFFER, ASCS_EXPIRE_SEND_MSG) can make the backlog shrink more than drained bytes
+		auto enqueued_size_in_byte = pending_size_in_byte + drained_size_in_byte > last_pending_size_in_byte ?
+			pending_size_in_byte + drained_size_in_byte - last_pending_size_in_byte : 0;
+		last_send_byte_sum = stat.send_byte_sum;
+		last_pending_size_in_byte = pending_size_in_byte;
+		drain_rate_ = (size_t) ((uint_fast64_t) drained_size_in_byte * 1000 / interval);
+		enqueue_rate_ = (size_t) ((uint_fast64_t) enqueued_size_in_byte * 1000 / interval);
+
+		if (pending_size_in_byte > 0 && 0 == drained_size_in_byte)
+			++stuck_num;
+		else
+			stuck_num = 0;
+
+		auto lag_size_in_byte = (uint_fast64_t) send_buf_size_ * ASCS_SLOW_CONSUMER_LAG_USAGE / 100;
+		auto state = consumer_state::HEALTHY;
+		if (stuck_num >= max_stuck)
+			state = consumer_state::STUCK;
+		else if (stuck_num > 0 || (enqueued_size_in_byte > drained_size_in_byte && pending_size_in_byte >= lag_size_in_byte))
+			state = consumer_state::LAGGING;
+		else if (consumer_state::HEALTHY != consumer_state_ && pending_size_in_byte >= lag_size_in_byte / 2) //still catching up
+			state = consumer_state::LAGGING;
+
+		auto prev_state = consumer_state_.exchange(state);
+		if (prev_state == state)
+			return true;
+		else if (consumer_state::LAGGING == state)
+			++stat.lagging_sum;
+		else if (consumer_state::STUCK == state)
+			++stat.stuck_sum;
+
+		return on_consumer_state_change(prev_state, state);
+	}
+#endif
+
 	virtual void do_recv_msg() = 0;
 	virtual bool do_send_msg(bool in_strand = false) = 0;
 
@@ -602,6 +1460,78 @@ private:
 
 	void _send_msg() {dispatch_in_io_strand([this]() {do_send_msg();});}
 
+#ifdef ASCS_CONSOLIDATE_FLUSH
+	//during a handler batch (on_msg or on_msg_handle of this socket), messages sent to this socket from the same thread will not be flushed
+	// immediately, but only mark the socket as dirty, then one flush (one gather write) will be issued at the end of the handler batch.
+	bool defer_sending()
+	{
+		if (std::this_thread::get_id() != flush_deferring_thread.load(std::memory_order_relaxed))
+#ifdef ASCS_SEND_LINGER
+			return linger_sending();
+#else
+			return false;
+#endif
+
+		flush_pending = true;
+		return true;
+	}
+
+	struct flush_deferrer
+	{
+		flush_deferrer(socket& owner_) : owner(owner_)
+		{
+			auto expected = std::thread::id(); //on_msg and on_msg_handle can be invoked concurrently, only the first one defers sending
+			deferring = owner.flush_deferring_thread.compare_exchange_strong(expected, std::this_thread::get_id(), std::memory_order_acquire, std::memory_order_relaxed);
+		}
+		~flush_deferrer()
+		{
+			if (deferring)
+			{
+				auto pending = owner.flush_pending;
+				owner.flush_pending = false;
+				owner.flush_deferring_thread.store(std::thread::id(), std::memory_order_release);
+				if (pending)
+					owner.send_msg();
+			}
+		}
+
+		socket& owner;
+		bool deferring;
+	};
+#elif defined(ASCS_SEND_LINGER)
+	bool defer_sending() {return linger_sending();}
+#else
+	bool defer_sending() const {return false;}
+#endif
+
+#ifdef ASCS_SEND_LINGER
+	//the first message arms the linger timer (in the IO strand), subsequent ones just wait for it, unless the pending messages reach the
+	// linger size. while the IO strand is sending, don't linger, messages will be sent right after the current batch.
+	bool linger_sending()
+	{
+		if (0 == send_linger_duration_ || is_sending() || pending_send_size_in_byte() >= send_linger_size_)
+			return false;
+		else if (!lingering.exchange(true, std::memory_order_acq_rel))
+			post_in_io_strand([this]() {arm_linger_timer();});
+
+		return true;
+	}
+
+	void arm_linger_timer()
+	{
+#if BOOST_ASIO_VERSION >= 101100
+		linger_timer.expires_after(std::chrono::microseconds(send_linger_duration_));
+#else
+		linger_timer.expires_from_now(std::chrono::microseconds(send_linger_duration_));
+#endif
+		linger_timer.async_wait(make_strand_handler(rw_strand, make_handler_error([this](const boost::system::error_code& ec) {
+			lingering.store(false, std::memory_order_release); //messages sent after this will arm the timer again
+			if (!ec && is_ready())
+				do_send_msg();
+		})));
+	}
+#endif
+
 #ifdef ASCS_SYNC_RECV
 	sync_call_result sync_recv_waiting(std::unique_lock<std::mutex>& lock, unsigned duration)
 	{
@@ -654,7 +1584,47 @@ private:
 	void dispatch_msg() {if (!dispatching) post_in_dis_strand([this]() {do_dispatch_msg();});}
 	void do_dispatch_msg()
 	{
-#ifdef ASCS_DISPATCH_BATCH_MSG
+#ifdef ASCS_CONSOLIDATE_FLUSH
+		flush_deferrer deferrer(*this);
+#endif
+#ifdef ASCS_DISPATCH_SPAN_MSG
+		if (dispatching_begin < dispatching_msgs.size() || fill_dispatching_msgs())
+		{
+			dispatching = true;
+			auto begin_time = statistic::now();
+			obj_span<out_msg> msg_span(dispatching_msgs.data() + dispatching_begin, dispatching_msgs.size() - dispatching_begin);
+#ifdef ASCS_FULL_STATISTIC
+			ascs::do_something_to_all(msg_span, [&](out_msg& msg) {stat.dispatch_delay_sum += begin_time - msg.begin_time;});
+#endif
+			auto re = on_msg_handle(msg_span);
+			auto end_time = statistic::now();
+			stat.handle_time_sum += end_time - begin_time;
+
+			assert(re <= msg_span.size());
+			dispatching_begin += std::min(re, msg_span.size());
+			if (dispatching_begin >= dispatching_msgs.size())
+			{
+				dispatching_msgs.clear(); //keep the capacity for reusing
+				dispatching_begin = 0;
+				dispatching_size_in_byte.store(0, std::memory_order_relaxed);
+			}
+			else //handled messages may have been changed (for example, moved out), so count the unhandled ones
+			{
+				size_t size_in_byte = 0;
+				std::for_each(dispatching_msgs.begin() + dispatching_begin, dispatching_msgs.end(), [&](out_msg& msg) {
+					size_in_byte += msg.size();
+#ifdef ASCS_FULL_STATISTIC
+					msg.restart(end_time);
+#endif
+				});
+				dispatching_size_in_byte.store(size_in_byte, std::memory_order_relaxed);
+			}
+
+			if (0 == re) //dispatch failed, re-dispatch
+				set_timer(TIMER_DISPATCH_MSG, msg_handling_interval_, [this](tid id)->bool {return timer_handler(id);}); //hold dispatching
+			else
+			{
+#elif defined(ASCS_DISPATCH_BATCH_MSG)
 		if (!recv_buffer.empty())
 		{
 			dispatching = true;
@@ -679,11 +1649,28 @@ private:
 		if (dispatching || recv_buffer.try_dequeue(dispatching_msg))
 		{
 			dispatching = true;
-			auto begin_time = statistic::now();
-			stat.dispatch_delay_sum += begin_time - dispatching_msg.begin_time;
-			auto re = on_msg_handle(dispatching_msg); //must before next msg dispatching to keep sequence
-			auto end_time = statistic::now();
+			auto begin_time = statistic::now(), end_time = begin_time;
+#ifdef ASCS_ADAPTIVE_DISPATCH_BUDGET
+			auto delay = begin_time - dispatching_msg.begin_time;
+#endif
+			auto budget_begin_time = 0 == dispatch_budget_duration_ ? std::chrono::steady_clock::time_point() : std::chrono::steady_clock::now();
+			size_t handled_num = 0;
+			auto re = true;
+			do
+			{
+				stat.dispatch_delay_sum += end_time - dispatching_msg.begin_time;
+				re = on_msg_handle(dispatching_msg); //must before next msg dispatching to keep sequence
+				end_time = statistic::now();
+				if (re)
+				{
+					dispatching_msg.clear();
+					++handled_num;
+				}
+			} while (re && is_in_dispatch_budget(handled_num, budget_begin_time) && recv_buffer.try_dequeue(dispatching_msg));
 			stat.handle_time_sum += end_time - begin_time;
+#ifdef ASCS_ADAPTIVE_DISPATCH_BUDGET
+			adjust_dispatch_budget(delay, handled_num);
+#endif
 
 			if (!re) //dispatch failed, re-dispatch
 			{
@@ -692,7 +1679,6 @@ private:
 			}
 			else
 			{
-				dispatching_msg.clear();
 #endif
 				dispatching = false;
 				post_in_dis_strand([this]() {do_dispatch_msg();}); //dispatch msg in sequence
@@ -702,6 +1688,52 @@ private:
 			dispatching = false;
 	}
 
+#ifdef ASCS_DISPATCH_SPAN_MSG
+	//move all messages in recv_buffer into dispatching_msgs, the former is taken out in one splice (with the default list container) to
+	// shorten the lock, the latter is only appended to, so its memory will be reused.
+	//messages in dispatching_msgs are still counted by recv flow control (see pending_recv_size_in_byte), the size is moved within the lock
+	// of recv_buffer, so the IO strand never sees them missing.
+	bool fill_dispatching_msgs()
+	{
+		out_container_type tmp_can;
+		{
+			typename out_queue_type::lock_guard lock(recv_buffer);
+			dispatching_size_in_byte.fetch_add(recv_buffer.size_in_byte(), std::memory_order_relaxed);
+			recv_buffer.move_items_out_(tmp_can);
+		}
+		if (tmp_can.empty())
+			return false;
+
+		ascs::do_something_to_all(tmp_can, [this](out_msg& msg) {dispatching_msgs.emplace_back(std::move(msg));});
+		return true;
+	}
+#elif !defined(ASCS_DISPATCH_BATCH_MSG)
+	bool is_in_dispatch_budget(size_t handled_num, const std::chrono::steady_clock::time_point& begin_time) const
+	{
+#ifdef ASCS_ADAPTIVE_DISPATCH_BUDGET
+		if (handled_num >= cur_dispatch_budget_num)
+#else
+		if (handled_num >= dispatch_budget_num_)
+#endif
+			return false;
+
+		return 0 == dispatch_budget_duration_ || std::chrono::steady_clock::now() - begin_time < std::chrono::microseconds(dispatch_budget_duration_);
+	}
+
+#ifdef ASCS_ADAPTIVE_DISPATCH_BUDGET
+	void adjust_dispatch_budget(const std::chrono::system_clock::duration& delay, size_t handled_num)
+	{
+		if (delay > std::chrono::microseconds(ASCS_DISPATCH_DELAY_TARGET))
+		{
+			if (handled_num >= cur_dispatch_budget_num) //we're falling behind
+				cur_dispatch_budget_num = std::min(cur_dispatch_budget_num * 2, dispatch_budget_num_);
+		}
+		else if (delay < std::chrono::microseconds(ASCS_DISPATCH_DELAY_TARGET / 2))
+			cur_dispatch_budget_num = std::max(cur_dispatch_budget_num / 2, (size_t) 1);
+	}
+#endif
+#endif
+
 	bool timer_handler(tid id)
 	{
 		switch (id)
@@ -735,49 +1767,165 @@ private:
 		return false;
 	}
 
+	//members are ordered by their writers (producer threads, the IO strand and the dispatch strand), groups can be separated by cache line
+	// paddings (opt-in), see macro ASCS_CACHE_LINE_SIZE. please keep this layout when adding new members.
+
+	//cold group, written rarely (creation, starting, closing and configuration)
+private:
+	std::shared_ptr<i_packer<typename Packer::msg_type>> packer_{make_shared_object<Packer>()};
+	std::shared_ptr<i_unpacker<typename Unpacker::msg_type>> unpacker_{make_shared_object<Unpacker>()};
+
+	volatile bool started_{false}; //has started or not
+	volatile bool obsoleted_{false};
+	std::atomic_flag start_atomic;
+
+	uint_fast64_t _id = -1;
+
 protected:
-	struct statistic stat;
-	std::list<OutMsgType> temp_msg_can;
+	strand_type rw_strand;
+
+private:
+	Socket next_layer_;
+	strand_type dis_strand;
+
+	size_t send_buf_size_{ASCS_MAX_SEND_BUF}, recv_buf_size_{ASCS_MAX_RECV_BUF};
+#ifdef ASCS_EXPIRE_SEND_MSG
+	std::atomic_uint send_msg_ttl_{ASCS_SEND_MSG_TTL};
+#endif
+#ifdef ASCS_SEND_LINGER
+	unsigned send_linger_duration_{ASCS_SEND_LINGER_DURATION};
+	size_t send_linger_size_{ASCS_SEND_LINGER_SIZE};
+#endif
+	unsigned msg_resuming_interval_{ASCS_MSG_RESUMING_INTERVAL}, msg_handling_interval_{ASCS_MSG_HANDLING_INTERVAL};
+#if !defined(ASCS_DISPATCH_BATCH_MSG) && !defined(ASCS_DISPATCH_SPAN_MSG)
+	size_t dispatch_budget_num_{ASCS_DISPATCH_BUDGET_MSG_NUM};
+	unsigned dispatch_budget_duration_{ASCS_DISPATCH_BUDGET_DURATION};
+#endif
+
+#ifdef ASCS_HEARTBEAT_SCHEDULER
+	heartbeat_scheduler& hb_scheduler;
+	size_t hb_index = -1; //index in hb_scheduler, maintained by hb_scheduler
+#endif
+
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	std::atomic<consumer_state> consumer_state_{consumer_state::HEALTHY};
+	std::atomic_size_t drain_rate_{0}, enqueue_rate_{0};
+	uint_fast64_t last_send_byte_sum{0};
+	size_t last_pending_size_in_byte{0};
+	unsigned stuck_num{0};
+#endif
 
+	//producer group, written by threads which send messages (and the IO strand when taking messages out)
+	ASCS_CACHE_LINE_PADDING(producer_padding)
+protected:
+#ifdef ASCS_SYNC_SEND
+	std::shared_ptr<sync_send_slot_pool> sync_send_slots{std::make_shared<sync_send_slot_pool>()}; //must be declared before all messages
+#endif
 	in_queue_type send_buffer;
-	boost::asio::io_context::strand rw_strand;
 
 private:
-	std::shared_ptr<i_packer<typename Packer::msg_type>> packer_{std::make_shared<Packer>()};
-	std::shared_ptr<i_unpacker<typename Unpacker::msg_type>> unpacker_{std::make_shared<Unpacker>()};
+#ifdef ASCS_CONFLATE_SEND_MSG
+	struct conflated_msg
+	{
+		in_container_type msgs;
+		size_t size_in_byte{0}, replaced_num{0};
+	};
+	std::mutex conflation_mutex;
+	std::list<uint_fast64_t> conflation_keys; //in the order of their first arrival, replacing doesn't change the order
+	std::unordered_map<uint_fast64_t, conflated_msg> conflation_msgs;
+	//written under conflation_mutex, read without it
+	std::atomic_size_t conflation_num{0}, conflation_size_in_byte{0};
+#endif
 
-	bool recv_idle_began{false};
-	volatile bool started_{false}; //has started or not
-	volatile bool obsoleted_{false};
+#ifdef ASCS_COALESCE_SEND_MSG
+	typename Packer::msg_type coalescing_slab; //protected by the send buffer's mutex
+	std::atomic_size_t coalescing_size{0}; //the size of the slab, written under the send buffer's mutex, read without it
+#endif
 
-	volatile bool dispatching{false};
-#ifndef ASCS_DISPATCH_BATCH_MSG
-	out_msg dispatching_msg;
+#ifdef ASCS_SEND_LINGER
+	std::atomic_bool lingering{false}; //the linger timer has been (or is being) armed
 #endif
 
-	typename statistic::stat_time recv_idle_begin_time;
-	out_queue_type recv_buffer;
+#ifdef ASCS_SPILL_SEND_BUFFER
+	std::mutex spill_mutex;
+	std::unique_ptr<FILE, int (*)(FILE*)> spill_file{nullptr, &fclose}; //created at the first spilling
+	fpos_t spill_read_pos, spill_write_pos;
+	std::atomic_size_t spilled_size_in_byte{0};
+#endif
 
-	uint_fast64_t _id = -1;
-	Socket next_layer_;
+#ifdef ASCS_SEND_STAGING
+	struct lane_owner {std::atomic<std::thread::id> id{std::thread::id()};};
+	std::array<lane_owner, ASCS_SEND_STAGING_LANE_NUM> lane_owners; //read mostly, a lane is claimed only once
+	char staged_padding[ASCS_SEND_STAGING_PADDING_SIZE]; //written by all producers
+	std::atomic_bool staged{false};
+	std::array<staging_lane_type, ASCS_SEND_STAGING_LANE_NUM> staging_lanes;
+#endif
+
+	//IO group, written by the IO strand (rw_strand)
+	ASCS_CACHE_LINE_PADDING(io_padding)
+protected:
+	std::list<OutMsgType> temp_msg_can;
 
+private:
+	std::atomic_size_t sending;
 #ifdef ASCS_PASSIVE_RECV
 	std::atomic_size_t reading;
 #endif
-	std::atomic_size_t sending;
-	std::atomic_flag start_atomic;
-	boost::asio::io_context::strand dis_strand;
+#ifdef ASCS_EXPIRE_SEND_MSG
+	uint_fast64_t last_batch_id{0}; //the batch (see unify_queued_time) which the last sent or dropped message belongs to
+	bool last_batch_expired{false}; //the fate of the batch above, later messages of the batch follow it
+#endif
+#ifdef ASCS_SEND_LINGER
+#if BOOST_ASIO_VERSION < 101100
+	boost::asio::steady_timer linger_timer{next_layer_.get_io_service()};
+#elif BOOST_ASIO_VERSION < 101300
+	boost::asio::steady_timer linger_timer{next_layer_.get_executor().context()};
+#else
+	boost::asio::steady_timer linger_timer{next_layer_.get_executor()};
+#endif
+#endif
+
+	bool recv_idle_began{false};
+	typename statistic::stat_time recv_idle_begin_time;
 
 #ifdef ASCS_SYNC_RECV
 	enum sync_recv_status {NOT_REQUESTED, REQUESTED, RESPONDED, RESPONDED_FAILURE};
-	sync_recv_status sr_status{sync_recv_status::NOT_REQUESTED};
+	std::atomic<sync_recv_status> sr_status{sync_recv_status::NOT_REQUESTED};
+	size_t sr_max_num{0}, sr_min_num{0};
+	std::list<OutMsgType> sync_recv_msgs; //collected for sync_recv_msg
+	size_t sync_recv_num{0}; //size of sync_recv_msgs
 
 	std::mutex sync_recv_mutex;
 	std::condition_variable sync_recv_cv;
 #endif
 
-	size_t send_buf_size_{ASCS_MAX_SEND_BUF}, recv_buf_size_{ASCS_MAX_RECV_BUF};
-	unsigned msg_resuming_interval_{ASCS_MSG_RESUMING_INTERVAL}, msg_handling_interval_{ASCS_MSG_HANDLING_INTERVAL};
+protected:
+	//IO strand written members come first in statistic, so it can be put at the end of the IO group, see statistic for more details.
+	struct statistic stat;
+
+private:
+	//shared by the IO strand (the producer) and the dispatch strand (the consumer), it has its own lock
+	ASCS_CACHE_LINE_PADDING(recv_padding)
+	out_queue_type recv_buffer;
+
+	//dispatch group, written by the dispatch strand (dis_strand)
+	ASCS_CACHE_LINE_PADDING(dispatch_padding)
+	volatile bool dispatching{false};
+#ifdef ASCS_DISPATCH_SPAN_MSG
+	std::vector<out_msg> dispatching_msgs;
+	size_t dispatching_begin{0}; //messages before it have been handled
+	std::atomic_size_t dispatching_size_in_byte{0}; //of unhandled messages in dispatching_msgs, read by the IO strand
+#elif !defined(ASCS_DISPATCH_BATCH_MSG)
+	out_msg dispatching_msg;
+#endif
+#ifdef ASCS_ADAPTIVE_DISPATCH_BUDGET
+	size_t cur_dispatch_budget_num{1};
+#endif
+
+#ifdef ASCS_CONSOLIDATE_FLUSH
+	std::atomic<std::thread::id> flush_deferring_thread{std::thread::id()};
+	bool flush_pending{false}; //only accessed by the thread recorded in flush_deferring_thread
+#endif
 };
 
 template<typename Socket, typename Packer, typename Unpacker,
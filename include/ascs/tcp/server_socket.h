@@ -63,6 +63,19 @@ protected:
 	virtual void on_recv_error(const boost::system::error_code& ec) {this->show_info(ec, "server link:", "broken/been shut down"); force_shutdown();}
 	virtual void on_async_shutdown_error() {force_shutdown();}
 	virtual bool on_heartbeat_error() {this->show_info("server link:", "broke unexpectedly."); force_shutdown(); return false;}
+#ifdef ASCS_SLOW_CONSUMER_CHECK
+	//one stuck client should not hold the server's memory forever
+	virtual bool on_consumer_state_change(consumer_state prev_state, consumer_state state)
+	{
+		super::on_consumer_state_change(prev_state, state);
+		if (consumer_state::STUCK != state)
+			return true;
+
+		this->show_info("server link:", "stuck consumer, been disconnected.");
+		force_shutdown();
+		return false;
+	}
+#endif
 
 	virtual void on_close()
 	{
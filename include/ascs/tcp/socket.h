@@ -15,17 +15,62 @@
 
 #include "../socket.h"
 
+#ifdef ASCS_ZEROCOPY_SEND
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY	60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY	0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY	5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED	1
+#endif
+#endif
+
 namespace ascs { namespace tcp {
 
+#ifdef ASCS_ZEROCOPY_SEND
+//holds messages which were sent with MSG_ZEROCOPY but whose connections were closed before the kernel notified us, no notifications will
+// come any more, so they are released (when other messages are handed over) ASCS_ZEROCOPY_REAP_DELAY seconds later.
+class zerocopy_reaper : public boost::noncopyable
+{
+public:
+	//leaked on purpose, like huge_page_arena
+	static zerocopy_reaper& instance() {static auto reaper = new zerocopy_reaper; return *reaper;}
+
+	void reap(std::shared_ptr<void>&& msgs)
+	{
+		auto now = std::chrono::steady_clock::now();
+		std::lock_guard<std::mutex> lock(mutex);
+		while (!held_msgs.empty() && held_msgs.front().first <= now)
+			held_msgs.pop_front();
+		held_msgs.emplace_back(now + std::chrono::seconds(ASCS_ZEROCOPY_REAP_DELAY), std::move(msgs));
+	}
+
+private:
+	zerocopy_reaper() {}
+
+private:
+	std::mutex mutex;
+	std::list<std::pair<std::chrono::steady_clock::time_point, std::shared_ptr<void>>> held_msgs;
+};
+#endif
+
 template<typename Socket, typename OutMsgType> class reader_writer : public Socket
 {
 public:
 	using Socket::Socket;
 
-	typedef std::function<void(const boost::system::error_code& ec, size_t bytes_transferred)> ReadWriteCallBack;
-
 protected:
-	bool async_read(ReadWriteCallBack&& call_back)
+	//call_back must be bound to the IO strand (rw_strand), and it can be move-only.
+	template<typename CallBack> bool async_read(CallBack&& call_back)
 	{
 		auto recv_buff = this->unpacker()->prepare_next_recv();
 		assert(boost::asio::buffer_size(recv_buff) > 0);
@@ -34,30 +79,263 @@ protected:
 			unified_out::error_out(ASCS_LLF " the unpacker returned an empty buffer, quit receiving!", this->id());
 			return false;
 		}
+#ifdef ASCS_INLINE_IO
+		else if (inline_read(recv_buff, call_back, inline_io_capable()))
+			return true;
+#endif
 
 		boost::asio::async_read(this->next_layer(), recv_buff, [this](const boost::system::error_code& ec, size_t bytes_transferred)->size_t {
-			return completion_checker(ec, bytes_transferred);}, std::forward<ReadWriteCallBack>(call_back));
+			return completion_checker(ec, bytes_transferred);}, std::forward<CallBack>(call_back));
 		return true;
 	}
 	bool parse_msg(size_t bytes_transferred, std::list<OutMsgType>& msg_can) {return this->unpacker()->parse_msg(bytes_transferred, msg_can);}
 
-	size_t batch_msg_send_size() const
+	size_t batch_msg_send_size() const {return send_batch_size;}
+	size_t batch_msg_send_num() const {return ASCS_MAX_SEND_IOV;}
+	//msg_can will be modified (on partial writes, the first unfinished buffer will be advanced), and must keep valid until call_back been invoked.
+	//call_back must be bound to the IO strand (rw_strand), and it can be move-only.
+#ifdef ASCS_ZEROCOPY_SEND
+	//flags only take effect on plain tcp sockets (see async_write_some), each successful write with MSG_ZEROCOPY consumes a notification id.
+	template<typename CallBack> void async_write(std::vector<boost::asio::const_buffer>& msg_can, CallBack&& call_back, int flags = 0)
 	{
-#ifdef ASCS_WANT_MSG_SEND_NOTIFY
-		return 0;
+		write_flags = flags;
 #else
-		return boost::asio::detail::default_max_transfer_size;
+	template<typename CallBack> void async_write(std::vector<boost::asio::const_buffer>& msg_can, CallBack&& call_back)
+	{
 #endif
+		writing_buffer = &msg_can;
+		writing_index = written_size = 0;
+		write_begin_time = std::chrono::steady_clock::now();
+
+		do_async_write(std::forward<CallBack>(call_back));
 	}
-	template<typename Buffer> void async_write(const Buffer& msg_can, ReadWriteCallBack&& call_back)
-		{boost::asio::async_write(this->next_layer(), msg_can, std::forward<ReadWriteCallBack>(call_back));}
 
 private:
+	//call_back travels with the writes (and the rest of a partial inline reading), so no type erasure (and no copying) is needed, the wrappers
+	// lose the associated executor of call_back, so they must be bound to the IO strand again.
+	template<typename CallBack> struct write_call_back
+	{
+		write_call_back(reader_writer* owner_, CallBack&& call_back_) : owner(owner_), call_back(std::move(call_back_)) {}
+		void operator()(const boost::system::error_code& ec, size_t bytes_transferred) {owner->write_handler(ec, bytes_transferred, call_back);}
+
+		reader_writer* owner;
+		CallBack call_back;
+	};
+
+#ifdef ASCS_INLINE_IO
+	template<typename CallBack> struct read_call_back
+	{
+		read_call_back(size_t offset_, CallBack&& call_back_) : offset(offset_), call_back(std::move(call_back_)) {}
+		void operator()(const boost::system::error_code& ec, size_t bytes_transferred) {call_back(ec, offset + bytes_transferred);}
+
+		size_t offset;
+		CallBack call_back;
+	};
+#endif
+
+	//a light weight view of buffers which have not been sent in the batch, no copying of the batch (iovec) is needed to launch the next writev.
+	struct buffer_range
+	{
+		typedef boost::asio::const_buffer value_type;
+		typedef const boost::asio::const_buffer* const_iterator;
+
+		const_iterator begin() const {return begin_;}
+		const_iterator end() const {return end_;}
+
+		const_iterator begin_, end_;
+	};
+
+#ifdef ASCS_ZEROCOPY_SEND
+protected:
+	//the number of successful writes with MSG_ZEROCOPY since the last reset, the kernel numbers them from zero per connection.
+	uint32_t zerocopy_id() const {return zerocopy_id_;}
+	void reset_zerocopy_id() {zerocopy_id_ = 0;}
+
+private:
+	template<typename Stream, typename Handler>
+	static void async_write_some(Stream& s, const buffer_range& buffs, int flags, Handler&& handler) {s.async_write_some(buffs, std::forward<Handler>(handler));}
+	template<typename Handler>
+	static void async_write_some(boost::asio::ip::tcp::socket& s, const buffer_range& buffs, int flags, Handler&& handler)
+		{s.async_send(buffs, flags, std::forward<Handler>(handler));}
+	template<typename Stream>
+	static size_t write_some(Stream& s, const buffer_range& buffs, int flags, boost::system::error_code& ec) {return s.write_some(buffs, ec);}
+	static size_t write_some(boost::asio::ip::tcp::socket& s, const buffer_range& buffs, int flags, boost::system::error_code& ec)
+		{return s.send(buffs, flags, ec);}
+#endif
+
+private:
+	template<typename CallBack> void do_async_write(CallBack call_back)
+	{
+#ifdef ASCS_INLINE_IO
+		if (inline_write(call_back, inline_io_capable()))
+			return;
+#endif
+		auto buff = writing_buffer->data();
+		write_call_back<CallBack> handler(this, std::move(call_back));
+#ifdef ASCS_ZEROCOPY_SEND
+		async_write_some(this->next_layer(), buffer_range{buff + writing_index, buff + writing_buffer->size()}, write_flags,
+#else
+		this->next_layer().async_write_some(buffer_range{buff + writing_index, buff + writing_buffer->size()},
+#endif
+			make_strand_handler(this->rw_strand, std::move(handler)));
+	}
+
+	template<typename CallBack> void write_handler(const boost::system::error_code& ec, size_t bytes_transferred, CallBack& call_back)
+	{
+		written_size += bytes_transferred;
+#ifdef ASCS_ZEROCOPY_SEND
+		if (0 != (write_flags & MSG_ZEROCOPY) && bytes_transferred > 0)
+			++zerocopy_id_;
+#endif
+		if (!ec)
+		{
+			auto& buff = *writing_buffer;
+			for (; writing_index < buff.size() && bytes_transferred >= boost::asio::buffer_size(buff[writing_index]); ++writing_index)
+				bytes_transferred -= boost::asio::buffer_size(buff[writing_index]);
+
+			if (writing_index < buff.size())
+			{
+				buff[writing_index] = buff[writing_index] + bytes_transferred;
+				do_async_write(std::move(call_back));
+				return;
+			}
+
+			adjust_send_batch_size();
+		}
+
+		call_back(ec, written_size);
+	}
+
+	//sending of one batch is too fast to be measured means the kernel absorbed it at once, so try bigger batches if it was full,
+	// otherwise, estimate the send rate and move the batch size (smoothly) toward the amount that can be sent in ASCS_SEND_BATCH_DURATION.
+	void adjust_send_batch_size()
+	{
+		static const size_t min_batch_size = 4 * 1024, max_batch_size = 1024 * 1024;
+		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - write_begin_time).count();
+		if (duration < 1000)
+		{
+			if (written_size >= send_batch_size)
+				send_batch_size = std::min(send_batch_size * 2, max_batch_size);
+		}
+		else
+		{
+			auto expected_size = (size_t) ((uint_fast64_t) written_size * ASCS_SEND_BATCH_DURATION * 1000 / duration);
+			send_batch_size = std::max(min_batch_size, std::min((send_batch_size + expected_size) / 2, max_batch_size));
+		}
+	}
+
 	size_t completion_checker(const boost::system::error_code& ec, size_t bytes_transferred)
 	{
 		auto_duration dur(this->stat.unpack_time_sum);
 		return this->unpacker()->completion_condition(ec, bytes_transferred);
 	}
+
+#ifdef ASCS_INLINE_IO
+	//ssl and websocket streams keep their own states, only plain stream sockets (tcp and unix domain) can be read and written inline.
+	typedef typename std::remove_reference<decltype(std::declval<Socket&>().next_layer())>::type next_layer_type;
+	typedef std::is_base_of<boost::asio::socket_base, next_layer_type> inline_io_capable;
+
+	bool make_non_blocking()
+	{
+		if (this->next_layer().non_blocking())
+			return true;
+
+		boost::system::error_code ec;
+		this->next_layer().non_blocking(true, ec); //without it, sync reading and writing will wait for readiness
+		return !ec;
+	}
+
+	//a sub sequence which skips offset bytes and has at most max_size bytes
+	static boost::asio::mutable_buffer sub_buffers(const boost::asio::mutable_buffer& buff, size_t offset, size_t max_size = -1)
+		{return boost::asio::buffer(buff + offset, max_size);}
+	template<typename Buffers>
+	static std::vector<boost::asio::mutable_buffer> sub_buffers(const Buffers& buffs, size_t offset, size_t max_size = -1)
+	{
+		std::vector<boost::asio::mutable_buffer> re;
+		for (auto iter = boost::asio::buffer_sequence_begin(buffs); max_size > 0 && iter != boost::asio::buffer_sequence_end(buffs); ++iter)
+		{
+			boost::asio::mutable_buffer buff(*iter);
+			if (offset >= buff.size())
+				offset -= buff.size();
+			else
+			{
+				re.emplace_back(boost::asio::buffer(buff + offset, max_size));
+				offset = 0;
+				max_size -= re.back().size();
+			}
+		}
+
+		return re;
+	}
+
+	//call backs of inline reading and writing will be invoked before async_read and async_write return, reading and writing started in
+	// them go to the asynchronous path, so the recursion depth is at most one.
+	template<typename Buffers, typename CallBack> bool inline_read(const Buffers& recv_buff, CallBack& call_back, std::false_type) {return false;}
+	template<typename Buffers, typename CallBack> bool inline_read(const Buffers& recv_buff, CallBack& call_back, std::true_type)
+	{
+		if (inline_reading || !make_non_blocking())
+			return false;
+
+		boost::system::error_code ec;
+		auto max_size = completion_checker(ec, 0); //the same as what boost::asio::async_read does
+		if (0 == max_size)
+			return false;
+
+		auto bytes_transferred = this->next_layer().read_some(sub_buffers(recv_buff, 0, max_size), ec);
+		if (ec) //would_block, or errors which will be reported by async_read
+			return false;
+		else if (0 != completion_checker(ec, bytes_transferred)) //need more data, read the rest asynchronously
+		{
+			read_call_back<typename std::decay<CallBack>::type> handler(bytes_transferred, std::move(call_back));
+			boost::asio::async_read(this->next_layer(), sub_buffers(recv_buff, bytes_transferred),
+				[this, bytes_transferred](const boost::system::error_code& ec, size_t bytes)->size_t {return completion_checker(ec, bytes_transferred + bytes);},
+				make_strand_handler(this->rw_strand, std::move(handler)));
+			return true;
+		}
+
+		inline_reading = true;
+		call_back(ec, bytes_transferred);
+		inline_reading = false;
+		return true;
+	}
+
+	template<typename CallBack> bool inline_write(CallBack& call_back, std::false_type) {return false;}
+	template<typename CallBack> bool inline_write(CallBack& call_back, std::true_type)
+	{
+		if (inline_writing || !make_non_blocking())
+			return false;
+
+		boost::system::error_code ec;
+		auto buff = writing_buffer->data();
+#ifdef ASCS_ZEROCOPY_SEND
+		auto bytes_transferred = write_some(this->next_layer(), buffer_range{buff + writing_index, buff + writing_buffer->size()}, write_flags, ec);
+#else
+		auto bytes_transferred = this->next_layer().write_some(buffer_range{buff + writing_index, buff + writing_buffer->size()}, ec);
+#endif
+		if (ec) //would_block, or errors which will be reported by async_write_some
+			return false;
+
+		inline_writing = true;
+		write_handler(ec, bytes_transferred, call_back); //partial writes go to the asynchronous path
+		inline_writing = false;
+		return true;
+	}
+#endif
+
+private:
+	//written by the IO strand
+	ASCS_CACHE_LINE_PADDING(io_padding)
+	size_t send_batch_size{boost::asio::detail::default_max_transfer_size};
+	std::vector<boost::asio::const_buffer>* writing_buffer{nullptr};
+	size_t writing_index{0}, written_size{0};
+	std::chrono::steady_clock::time_point write_begin_time;
+#ifdef ASCS_ZEROCOPY_SEND
+	int write_flags{0};
+	uint32_t zerocopy_id_{0};
+#endif
+#ifdef ASCS_INLINE_IO
+	bool inline_reading{false}, inline_writing{false};
+#endif
 };
 
 template<typename Socket, typename Packer, typename Unpacker,
@@ -217,6 +495,18 @@ public:
 	TCP_SYNC_SAFE_SEND_MSG(sync_safe_send_msg, sync_send_msg)
 	TCP_SYNC_SAFE_SEND_MSG(sync_safe_send_native_msg, sync_send_native_msg)
 #endif
+#ifdef ASCS_CONFLATE_SEND_MSG
+	//like send_msg, but the message will replace the pending one with the same key, see macro ASCS_CONFLATE_SEND_MSG for more details.
+	bool conflate_send_msg(uint_fast64_t key, const char* pstr, size_t len, bool can_overflow = false)
+	{
+		auto_duration dur(stat.pack_time_sum);
+		auto msg = this->packer()->pack_msg(&pstr, &len, 1);
+		dur.end();
+		return this->direct_conflate_send_msg(key, std::move(msg), can_overflow);
+	}
+	template<typename Buffer> bool conflate_send_msg(uint_fast64_t key, const Buffer& buffer, bool can_overflow = false)
+		{return conflate_send_msg(key, buffer.data(), buffer.size(), can_overflow);}
+#endif
 #ifdef ASCS_EXPOSE_SEND_INTERFACE
 	using super::send_msg;
 #endif
@@ -237,6 +527,9 @@ protected:
 		status = link_status::CONNECTED;
 		stat.establish_time = time(nullptr);
 
+#ifdef ASCS_ZEROCOPY_SEND
+		enable_zerocopy(zerocopy_capable());
+#endif
 		on_connect(); //in this virtual function, stat.last_recv_time has not been updated (super::do_start will update it), please note
 		return super::do_start();
 	}
@@ -268,6 +561,9 @@ protected:
 	{
 #ifdef ASCS_SYNC_SEND
 		ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& msg) {if (msg.p) msg.p->set_value(sync_call_result::NOT_APPLICABLE);});
+#endif
+#ifdef ASCS_ZEROCOPY_SEND
+		stop_zerocopy(zerocopy_capable());
 #endif
 		status = link_status::BROKEN;
 		super::on_close();
@@ -378,7 +674,7 @@ private:
 
 	virtual bool do_send_msg(bool in_strand = false)
 	{
-		if (send_buffer.empty()) //without this, in extreme circumstances, messages can leave behind in the send buffer until the next message sending
+		if (this->is_send_buffer_empty(this->batch_msg_send_size())) //without this, in extreme circumstances, messages can leave behind in the send buffer until the next message sending
 		{
 			if (in_strand)
 				this->clear_sending();
@@ -389,7 +685,15 @@ private:
 			return true;
 
 		auto end_time = statistic::now();
-		send_buffer.move_items_out(this->batch_msg_send_size(), sending_msgs);
+		send_buffer.move_items_out(this->batch_msg_send_size(), this->batch_msg_send_num(), sending_msgs);
+#ifdef ASCS_EXPIRE_SEND_MSG
+		this->drop_expired_send_msgs(sending_msgs);
+		while (sending_msgs.empty() && !send_buffer.empty()) //all messages in this batch expired
+		{
+			send_buffer.move_items_out(this->batch_msg_send_size(), this->batch_msg_send_num(), sending_msgs);
+			this->drop_expired_send_msgs(sending_msgs);
+		}
+#endif
 		sending_buffer.clear(); //this buffer will not be refreshed according to sending_msgs timely
 		ascs::do_something_to_all(sending_msgs, [&](typename super::in_msg& item) {
 			this->stat.send_delay_sum += end_time - item.begin_time;
@@ -399,6 +703,11 @@ private:
 		if (!sending_buffer.empty())
 		{
 			sending_msgs.front().restart();
+#ifdef ASCS_ZEROCOPY_SEND
+			if (zerocopy_batch(zerocopy_capable()))
+				zerocopy_write(zerocopy_capable());
+			else
+#endif
 			this->async_write(sending_buffer, make_strand_handler(rw_strand,
 				this->make_handler_error_size([this](const boost::system::error_code& ec, size_t bytes_transferred) {send_handler(ec, bytes_transferred);})));
 			return true;
@@ -422,12 +731,12 @@ private:
 			ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& item) {if (item.p) {item.p->set_value(sync_call_result::SUCCESS);}});
 #endif
 #ifdef ASCS_WANT_MSG_SEND_NOTIFY
-			this->on_msg_send(sending_msgs.front());
+			ascs::do_something_to_all(sending_msgs, [this](typename super::in_msg& item) {this->on_msg_send(item);}); //in the sending order
 #elif defined(ASCS_WANT_BATCH_MSG_SEND_NOTIFY)
 			on_msg_send(sending_msgs);
 #endif
 #ifdef ASCS_WANT_ALL_MSG_SEND_NOTIFY
-			if (send_buffer.empty())
+			if (this->is_send_buffer_empty(this->batch_msg_send_size()))
 #if defined(ASCS_WANT_MSG_SEND_NOTIFY) || !defined(ASCS_WANT_BATCH_MSG_SEND_NOTIFY)
 				this->on_all_msg_send(sending_msgs.back());
 #else
@@ -441,12 +750,16 @@ private:
 				}
 			}
 #endif
+#endif
+#ifdef ASCS_ZEROCOPY_SEND
+			if (zerocopy_writing)
+				hold_zerocopy_msgs(zerocopy_capable()); //the kernel may still be reading them
 #endif
 			sending_msgs.clear();
 #ifdef ASCS_ARBITRARY_SEND
 			do_send_msg(true);
 #else
-			if (!do_send_msg(true) && !send_buffer.empty()) //send msg in sequence
+			if (!do_send_msg(true) && !this->is_send_buffer_empty(this->batch_msg_send_size())) //send msg in sequence
 				super::send_msg(); //just make sure no pending msgs
 #endif
 		}
@@ -456,12 +769,139 @@ private:
 			ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& item) {if (item.p) {item.p->set_value(sync_call_result::NOT_APPLICABLE);}});
 #endif
 			on_send_error(ec, sending_msgs);
+#ifdef ASCS_ZEROCOPY_SEND
+			if (zerocopy_writing)
+				hold_zerocopy_msgs(zerocopy_capable()); //the kernel may have sent part of them with MSG_ZEROCOPY
+#endif
 			sending_msgs.clear(); //clear sending messages after on_send_error, then user can decide how to deal with them in on_send_error
 
 			this->clear_sending();
 		}
 	}
 
+#ifdef ASCS_ZEROCOPY_SEND
+	//ssl and websocket encrypt or frame messages into their own buffers, and unix domain sockets don't support MSG_ZEROCOPY.
+	typedef std::is_same<Socket, boost::asio::ip::tcp::socket> zerocopy_capable;
+
+	void enable_zerocopy(std::false_type) {}
+	void enable_zerocopy(std::true_type)
+	{
+		int on = 1;
+		zerocopy_on = 0 == setsockopt(this->lowest_layer().native_handle(), SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on));
+		this->reset_zerocopy_id();
+
+		std::lock_guard<std::mutex> lock(zerocopy_mutex);
+		reap_zerocopy_msgs(); //left by the previous connection (if on_close didn't see it closed), notification ids restart from zero
+	}
+
+	bool zerocopy_batch(std::false_type) const {return false;}
+	bool zerocopy_batch(std::true_type) const
+	{
+		if (zerocopy_on)
+			for (auto& item : sending_msgs)
+				if (item.size() >= ASCS_ZEROCOPY_MIN_SIZE)
+					return true;
+
+		return false;
+	}
+
+	void zerocopy_write(std::false_type) {}
+	void zerocopy_write(std::true_type)
+	{
+		zerocopy_writing = true;
+		this->async_write(sending_buffer, make_strand_handler(rw_strand,
+			this->make_handler_error_size([this](const boost::system::error_code& ec, size_t bytes_transferred) {send_handler(ec, bytes_transferred);})), MSG_ZEROCOPY);
+	}
+
+	//all writes of this batch are numbered below the current zerocopy_id, the batch can be released after the kernel notified them all.
+	void hold_zerocopy_msgs(std::false_type) {}
+	void hold_zerocopy_msgs(std::true_type)
+	{
+		zerocopy_writing = false;
+
+		std::lock_guard<std::mutex> lock(zerocopy_mutex);
+		zerocopy_msgs.emplace_back();
+		zerocopy_msgs.back().first = this->zerocopy_id();
+		zerocopy_msgs.back().second.swap(sending_msgs);
+		handle_zerocopy_notifications();
+	}
+
+	//held messages are not released here, the kernel may still be reading them.
+	void stop_zerocopy(std::false_type) {}
+	void stop_zerocopy(std::true_type)
+	{
+		std::lock_guard<std::mutex> lock(zerocopy_mutex);
+		zerocopy_on = false;
+		zerocopy_writing = false;
+		if (!this->lowest_layer().is_open())
+			reap_zerocopy_msgs();
+	}
+
+	//zerocopy_mutex must be locked, the connection has been closed, so no notifications will come any more
+	void reap_zerocopy_msgs()
+	{
+		if (!zerocopy_msgs.empty())
+		{
+			auto msgs = std::make_shared<decltype(zerocopy_msgs)>();
+			msgs->swap(zerocopy_msgs);
+			zerocopy_reaper::instance().reap(std::move(msgs));
+		}
+	}
+
+	//zerocopy_mutex must be locked
+	void handle_zerocopy_notifications()
+	{
+		drain_zerocopy_notifications();
+		if (!zerocopy_waiting && !zerocopy_msgs.empty())
+		{
+			zerocopy_waiting = true;
+			this->lowest_layer().async_wait(boost::asio::socket_base::wait_error, make_strand_handler(rw_strand,
+				this->make_handler_error([this](const boost::system::error_code& ec) {
+					std::lock_guard<std::mutex> lock(zerocopy_mutex);
+					zerocopy_waiting = false;
+					if (this->lowest_layer().is_open())
+						handle_zerocopy_notifications();
+					else
+						reap_zerocopy_msgs();
+				})));
+			//the error queue is edge triggered, notifications which arrived before the waiting took effect will not wake it up
+			drain_zerocopy_notifications();
+		}
+	}
+
+	//zerocopy_mutex must be locked
+	void drain_zerocopy_notifications()
+	{
+		char control[256];
+		for (;;)
+		{
+			msghdr msg{};
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof(control);
+			if (recvmsg(this->lowest_layer().native_handle(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+				break; //no more notifications
+
+			for (auto cmsg = CMSG_FIRSTHDR(&msg); nullptr != cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+			{
+				if (!(SOL_IP == cmsg->cmsg_level && IP_RECVERR == cmsg->cmsg_type) && !(SOL_IPV6 == cmsg->cmsg_level && IPV6_RECVERR == cmsg->cmsg_type))
+					continue;
+
+				auto err = (const sock_extended_err*) CMSG_DATA(cmsg);
+				if (SO_EE_ORIGIN_ZEROCOPY != err->ee_origin || 0 != err->ee_errno)
+					continue;
+
+				//zero-copy costs more than copying if the kernel copies anyway
+				if (0 != (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && zerocopy_on.exchange(false))
+					unified_out::info_out(ASCS_LLF " the kernel copied messages which were sent with MSG_ZEROCOPY, give up zero-copy.", this->id());
+
+				//notification [ee_info, ee_data] covers a range of writes, and tcp notifies writes in order
+				while (!zerocopy_msgs.empty() && (int32_t) (err->ee_data + 1 - zerocopy_msgs.front().first) >= 0)
+					zerocopy_msgs.pop_front();
+			}
+		}
+	}
+#endif
+
 	bool shutdown_handler(size_t loop_num)
 	{
 		if (link_status::GRACEFUL_SHUTTING_DOWN == status)
@@ -483,6 +923,8 @@ private:
 	}
 
 protected:
+	//read by threads which send messages (is_ready), keep it away from the dispatch group at the end of ascs::socket
+	ASCS_CACHE_LINE_PADDING(status_padding)
 	volatile link_status status{link_status::BROKEN};
 
 private:
@@ -492,10 +934,18 @@ private:
 	using super::send_buffer;
 	using super::rw_strand;
 
+	//written by the IO strand
+	ASCS_CACHE_LINE_PADDING(io_padding)
 	//before gcc 5.0, std::list::size() has linear complexity, very embarrassing!
 	//so use std::vector (member variable) to reduce memory allocation and keep the number of sending msgs (its size() has constant complexity, it's very important).
 	typename super::in_container_type sending_msgs;
 	std::vector<boost::asio::const_buffer> sending_buffer;
+#ifdef ASCS_ZEROCOPY_SEND
+	bool zerocopy_writing{false}, zerocopy_waiting{false};
+	std::atomic_bool zerocopy_on{false}; //SO_ZEROCOPY has been set on the current connection, and zero-copy has not been given up
+	std::mutex zerocopy_mutex; //held batches are released by notifications
+	std::list<std::pair<uint32_t, typename super::in_container_type>> zerocopy_msgs;
+#endif
 };
 
 }} //namespace
@@ -46,13 +46,10 @@ class stream : public LowestLayerGetter<boost::beast::websocket::stream<NextLaye
 private:
 	typedef LowestLayerGetter<boost::beast::websocket::stream<NextLayer>> super;
 
-public:
-	typedef std::function<void(const boost::system::error_code& ec, size_t bytes_transferred)> ReadWriteCallBack;
-
 public:
 	template<class... Args> explicit stream(Args&&... args) : super(std::forward<Args>(args)...) {this->binary(ASCS_WEBSOCKET_BINARY);}
 
-	void async_read(const ReadWriteCallBack& call_back) {super::async_read(recv_buff, call_back);}
+	template<typename CallBack> void async_read(CallBack&& call_back) {super::async_read(recv_buff, std::forward<CallBack>(call_back));}
 	template<typename OutMsgType> bool parse_msg(list<OutMsgType>& msg_can)
 	{
 #if BOOST_VERSION < 107000
@@ -65,7 +62,7 @@ public:
 
 		return re;
 	}
-	template<typename Buffer> void async_write(const Buffer& buff, const ReadWriteCallBack& call_back) {super::async_write(buff, call_back);}
+	template<typename Buffer, typename CallBack> void async_write(const Buffer& buff, CallBack&& call_back) {super::async_write(buff, std::forward<CallBack>(call_back));}
 
 private:
 	boost::beast::flat_buffer recv_buff;
@@ -77,11 +74,12 @@ public:
 	using Socket::Socket;
 
 protected:
-	template<typename CallBack> bool async_read(const CallBack& call_back) {this->next_layer().async_read(call_back); return true;}
+	template<typename CallBack> bool async_read(CallBack&& call_back) {this->next_layer().async_read(std::forward<CallBack>(call_back)); return true;}
 	bool parse_msg(size_t bytes_transferred, list<OutMsgType>& msg_can) {return this->next_layer().parse_msg(msg_can);}
 
 	size_t batch_msg_send_size() const {return 0;}
-	template<typename Buffer, typename CallBack> void async_write(const Buffer& msg_can, const CallBack& call_back) {this->next_layer().async_write(msg_can, call_back);}
+	size_t batch_msg_send_num() const {return 1;}
+	template<typename Buffer, typename CallBack> void async_write(const Buffer& msg_can, CallBack&& call_back) {this->next_layer().async_write(msg_can, std::forward<CallBack>(call_back));}
 };
 
 template<typename Socket> class socket : public Socket
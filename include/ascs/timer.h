@@ -13,12 +13,16 @@
 #ifndef _ASCS_TIMER_H_
 #define _ASCS_TIMER_H_
 
-#ifdef ASCS_USE_STEADY_TIMER
+#ifdef ASCS_TIMING_WHEEL
+#include "timing_wheel.h"
+#elif defined(ASCS_USE_STEADY_TIMER)
 #include <boost/asio/steady_timer.hpp>
 #else
 #include <boost/asio/system_timer.hpp>
 #endif
 
+#include <array>
+
 #include "base.h"
 
 //If you inherit a class from class X, your own timer ids must begin from X::TIMER_END
@@ -37,7 +41,9 @@ template<typename Executor>
 class timer : public Executor
 {
 public:
-#ifdef ASCS_USE_STEADY_TIMER
+#ifdef ASCS_TIMING_WHEEL
+	typedef timing_wheel::wheel_timer timer_type;
+#elif defined(ASCS_USE_STEADY_TIMER)
 	typedef boost::asio::steady_timer timer_type;
 #else
 	typedef boost::asio::system_timer timer_type;
@@ -52,7 +58,7 @@ public:
 
 		tid id;
 		unsigned char seq = -1;
-		timer_status status{TIMER_CREATED};
+		std::atomic<timer_status> status{TIMER_CREATED};
 		unsigned interval_ms{0};
 		timer_type timer;
 		std::function<bool(tid)> call_back; //return true from call_back to continue the timer, or the timer will stop
@@ -63,7 +69,7 @@ public:
 	};
 	typedef const timer_info timer_cinfo;
 
-	using Executor::Executor;
+	timer(boost::asio::io_context& io_context_) : Executor(io_context_) {for (auto& item : timer_slots) item.store(nullptr, std::memory_order_relaxed);}
 	~timer() {stop_all_timer();}
 
 	unsigned get_io_context_refs() const {return io_context_refs;}
@@ -87,17 +93,19 @@ public:
 
 	bool create_or_update_timer(tid id, unsigned interval, std::function<bool(tid)>&& call_back, bool start = false)
 	{
-		timer_info* ti = nullptr;
+		auto ti = find_timer(id);
+		if (nullptr == ti)
 		{
 			std::lock_guard<std::mutex> lock(timer_can_mutex);
-			auto iter = std::find(std::begin(timer_can), std::end(timer_can), id);
-			if (iter == std::end(timer_can))
+			ti = id < ASCS_TIMER_SLOT_NUM ? timer_slots[id].load(std::memory_order_relaxed) : do_find_timer(id); //check again with the mutex
+			if (nullptr == ti)
 			{
 				try {timer_can.emplace_back(id, io_context_); ti = &timer_can.back();}
 				catch (const std::exception& e) {unified_out::error_out("cannot create timer %d (%s)", id, e.what()); return false;}
+
+				if (id < ASCS_TIMER_SLOT_NUM)
+					timer_slots[id].store(ti, std::memory_order_release);
 			}
-			else
-				ti = &*iter;
 		}
 		assert (nullptr != ti);
 
@@ -121,14 +129,15 @@ public:
 	bool set_timer(tid id, unsigned interval, std::function<bool(tid)>&& call_back) {return create_or_update_timer(id, interval, std::move(call_back), true);}
 	bool set_timer(tid id, unsigned interval, const std::function<bool(tid)>& call_back) {return create_or_update_timer(id, interval, call_back, true);}
 
+	//timers are never destroyed until the timer object itself been destroyed, so for timers whose id is less than ASCS_TIMER_SLOT_NUM,
+	// finding them is just a load from the slot without any locks.
 	timer_info* find_timer(tid id)
 	{
-		std::lock_guard<std::mutex> lock(timer_can_mutex);
-		auto iter = std::find(std::begin(timer_can), std::end(timer_can), id);
-		if (iter != std::end(timer_can))
-			return &*iter;
+		if (id < ASCS_TIMER_SLOT_NUM)
+			return timer_slots[id].load(std::memory_order_acquire);
 
-		return nullptr;
+		std::lock_guard<std::mutex> lock(timer_can_mutex);
+		return do_find_timer(id);
 	}
 
 	bool is_timer(tid id) {auto ti = find_timer(id); return nullptr != ti ? timer_info::TIMER_STARTED == ti->status : false;}
@@ -147,18 +156,12 @@ protected:
 			return false;
 
 		ti.status = timer_info::TIMER_STARTED;
-#if BOOST_ASIO_VERSION >= 101100
-		ti.timer.expires_after(std::chrono::milliseconds(interval_ms));
-#else
-		ti.timer.expires_from_now(std::chrono::milliseconds(interval_ms));
-#endif
-
 		//if timer already started, this will cancel it first
 #if (_MSVC_LANG > 201103L || __cplusplus > 201103L)
-		ti.timer.async_wait(this->make_handler_error([this, &ti, prev_seq(++ti.seq)](const boost::system::error_code& ec) {
+		async_wait_timer(ti.timer, interval_ms, this->make_handler_error([this, &ti, prev_seq(++ti.seq)](const boost::system::error_code& ec) {
 #else
 		auto prev_seq = ++ti.seq;
-		ti.timer.async_wait(this->make_handler_error([this, &ti, prev_seq](const boost::system::error_code& ec) {
+		async_wait_timer(ti.timer, interval_ms, this->make_handler_error([this, &ti, prev_seq](const boost::system::error_code& ec) {
 #endif
 			//the first 'timer_info::TIMER_STARTED == ti.status' judgement means stop_timer can also invalidate cumulative timer callbacks
 			//the second 'timer_info::TIMER_STARTED == ti.status' judgement is used to exclude a particular situation--stop the same timer in call_back and return true
@@ -199,9 +202,30 @@ protected:
 	virtual void detach_io_context(boost::asio::io_context& io_context_, unsigned refs) {}
 
 private:
+#ifdef ASCS_TIMING_WHEEL
+	template<typename F> static void async_wait_timer(timer_type& timer, unsigned interval_ms, F&& handler) {timer.async_wait(interval_ms, std::forward<F>(handler));}
+#else
+	template<typename F> static void async_wait_timer(timer_type& timer, unsigned interval_ms, F&& handler)
+	{
+#if BOOST_ASIO_VERSION >= 101100
+		timer.expires_after(std::chrono::milliseconds(interval_ms));
+#else
+		timer.expires_from_now(std::chrono::milliseconds(interval_ms));
+#endif
+		timer.async_wait(std::forward<F>(handler));
+	}
+#endif
+
+	timer_info* do_find_timer(tid id) //timer_can_mutex must be held
+	{
+		auto iter = std::find(std::begin(timer_can), std::end(timer_can), id);
+		return iter == std::end(timer_can) ? nullptr : &*iter;
+	}
+
 	typedef std::list<timer_info> container_type;
 	container_type timer_can;
 	std::mutex timer_can_mutex;
+	std::array<std::atomic<timer_info*>, ASCS_TIMER_SLOT_NUM> timer_slots; //index is the timer id
 
 	using Executor::io_context_;
 	unsigned io_context_refs{1};
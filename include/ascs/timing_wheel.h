@@ -0,0 +1,225 @@
+/*
+ * timing_wheel.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: youngwolf
+ *		email: mail2tao@163.com
+ *		QQ: 676218192
+ *		Community on QQ: 198941541
+ *
+ * hierarchical timing wheel, one for each io_context
+ */
+
+#ifndef _ASCS_TIMING_WHEEL_H_
+#define _ASCS_TIMING_WHEEL_H_
+
+#include <array>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include "base.h"
+
+namespace ascs
+{
+
+//a hierarchical timing wheel (ASCS_TIMING_WHEEL_LEVEL levels, 256 slots in each level), it works as a boost::asio service, so each io_context has
+// its own timing wheel, and all timers in the same io_context share only one asio timer, which ticks every ASCS_TIMING_WHEEL_TICK milliseconds
+// if there're armed timers (otherwise it stops ticking).
+//arming and canceling a timer are O(1), timers expire at the same tick will be handled in one batch (in the order of arming), so the precision
+// of the timers is one tick, and a timer never expires before its interval.
+class timing_wheel : public boost::asio::detail::service_base<timing_wheel>
+{
+public:
+	typedef move_only_function<void(const boost::system::error_code&)> handler_type; //handlers can be move-only (see tracked_handler)
+
+	struct node //intrusive node of the slots (doubly-linked circular lists)
+	{
+		node* prev{nullptr};
+		node* next{nullptr};
+		uint_fast64_t expiry{0}; //in ticks
+		handler_type handler;
+
+		bool linked() const {return nullptr != prev;}
+	};
+
+	//a substitute of boost::asio::steady_timer, but only provides asynchronous waiting
+	class wheel_timer : public boost::noncopyable
+	{
+	public:
+		wheel_timer(boost::asio::io_context& io_context_) : wheel(boost::asio::use_service<timing_wheel>(io_context_)) {}
+		~wheel_timer() {cancel();}
+
+		//if the timer is already armed, it will be canceled first
+		void async_wait(unsigned interval_ms, handler_type&& handler) {wheel.async_wait(n, interval_ms, std::move(handler));}
+		//unlike boost::asio::steady_timer, the handler will be discarded without being invoked
+		bool cancel() {return wheel.cancel(n);}
+
+	private:
+		timing_wheel& wheel;
+		node n;
+	};
+
+public:
+	timing_wheel(boost::asio::io_context& io_context_) : service_base<timing_wheel>(io_context_), tick_timer(io_context_), begin_time(std::chrono::steady_clock::now())
+		{for (auto& item : slots) item.prev = item.next = &item;}
+
+	void async_wait(node& n, unsigned interval_ms, handler_type&& handler)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (n.linked())
+			unlink(n);
+		else
+			++node_num;
+
+		if (!ticking && 1 == node_num) //the wheel was idle, skip the passed ticks
+			cur_tick = std::max(cur_tick, now_tick());
+
+		auto due = std::chrono::steady_clock::now() - begin_time + std::chrono::milliseconds(interval_ms);
+		auto tick = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::milliseconds(ASCS_TIMING_WHEEL_TICK));
+		n.expiry = std::max(cur_tick + 1, (uint_fast64_t) ((due.count() + tick.count() - 1) / tick.count())); //round up
+		n.handler.swap(handler);
+		link(n);
+
+		start_ticking();
+	}
+
+	bool cancel(node& n)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!n.linked())
+			return false;
+
+		unlink(n);
+		--node_num;
+		n.handler = nullptr;
+
+		return true;
+	}
+
+	size_t size() const {return node_num;} //armed timers
+
+private:
+#if BOOST_ASIO_VERSION >= 101100
+	virtual void shutdown()
+#else
+	virtual void shutdown_service()
+#endif
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& item : slots)
+			while (item.next != &item)
+			{
+				auto& n = *item.next;
+				unlink(n);
+				n.handler = nullptr;
+			}
+		node_num = 0;
+	}
+
+	uint_fast64_t now_tick() const
+		{return (uint_fast64_t) (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin_time).count() / ASCS_TIMING_WHEEL_TICK);}
+
+	static void unlink(node& n) {n.prev->next = n.next; n.next->prev = n.prev; n.prev = n.next = nullptr;}
+	void link(node& n) //n.expiry must be bigger than or equal to cur_tick
+	{
+		auto delta = n.expiry - cur_tick;
+		auto expiry = n.expiry;
+		size_t level = 0;
+		while (level + 1 < ASCS_TIMING_WHEEL_LEVEL && delta >> (8 * (level + 1)) > 0)
+			++level;
+		if (delta >> (8 * (level + 1)) > 0) //beyond the range of the wheel, put it to the farthest slot, it will be re-linked when cascading
+			expiry = cur_tick + (((uint_fast64_t) 1 << (8 * (level + 1))) - 1);
+
+		auto& head = slots[level * 256 + ((expiry >> (8 * level)) & 0xFF)];
+		n.prev = head.prev;
+		n.next = &head;
+		head.prev->next = &n;
+		head.prev = &n;
+	}
+
+	void cascade(size_t level)
+	{
+		auto& head = slots[level * 256 + ((cur_tick >> (8 * level)) & 0xFF)];
+		if (head.next == &head)
+			return;
+
+		node tmp_head; //move all nodes out first, because they may be re-linked into the same slot (if beyond the range of the wheel)
+		tmp_head.prev = head.prev;
+		tmp_head.next = head.next;
+		tmp_head.prev->next = tmp_head.next->prev = &tmp_head;
+		head.prev = head.next = &head;
+
+		while (tmp_head.next != &tmp_head)
+		{
+			auto& n = *tmp_head.next;
+			unlink(n);
+			link(n);
+		}
+	}
+
+	void advance(std::vector<handler_type>& expired_handlers)
+	{
+		++cur_tick;
+
+		size_t level = 0; //the highest level need to be cascaded
+		while (level + 1 < ASCS_TIMING_WHEEL_LEVEL && 0 == (cur_tick & (((uint_fast64_t) 1 << (8 * (level + 1))) - 1)))
+			++level;
+		for (; level > 0; --level)
+			cascade(level);
+
+		auto& head = slots[cur_tick & 0xFF];
+		while (head.next != &head)
+		{
+			auto& n = *head.next;
+			unlink(n);
+			--node_num;
+
+			expired_handlers.emplace_back(std::move(n.handler));
+			n.handler = nullptr;
+		}
+	}
+
+	void start_ticking() //mutex must be held
+	{
+		if (ticking || 0 == node_num)
+			return;
+
+		ticking = true;
+		tick_timer.expires_at(begin_time + std::chrono::milliseconds((cur_tick + 1) * ASCS_TIMING_WHEEL_TICK));
+		tick_timer.async_wait([this](const boost::system::error_code& ec) {if (!ec) handle_tick();});
+	}
+
+	void handle_tick()
+	{
+		std::vector<handler_type> expired_handlers;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ticking = false;
+
+			auto target_tick = now_tick();
+			while (cur_tick < target_tick && node_num > 0)
+				advance(expired_handlers);
+			if (0 == node_num)
+				cur_tick = std::max(cur_tick, target_tick);
+
+			start_ticking();
+		}
+
+		boost::system::error_code ec;
+		ascs::do_something_to_all(expired_handlers, [&](handler_type& item) {item(ec);});
+	}
+
+private:
+	boost::asio::steady_timer tick_timer;
+	std::chrono::steady_clock::time_point begin_time;
+	uint_fast64_t cur_tick{0};
+	bool ticking{false};
+
+	std::array<node, 256 * ASCS_TIMING_WHEEL_LEVEL> slots; //heads of slots
+	size_t node_num{0};
+	std::mutex mutex;
+};
+
+} //namespace
+
+#endif /* _ASCS_TIMING_WHEEL_H_ */
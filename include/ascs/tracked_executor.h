@@ -19,6 +19,38 @@ namespace ascs
 {
 	
 #if 0 == ASCS_DELAY_CLOSE
+//holds one reference of the asynchronous calling indicator (an intrusive counter) of a tracked_executor, it's move-only, and moving it doesn't
+// touch the counter, so each asynchronous call costs exactly one increment and one decrement.
+class async_call_holder
+{
+public:
+	explicit async_call_holder(std::atomic_uint& aci_) : aci(&aci_) {aci->fetch_add(1, std::memory_order_relaxed);}
+	async_call_holder(const async_call_holder&) = delete;
+	async_call_holder(async_call_holder&& other) : aci(other.aci) {other.aci = nullptr;}
+	~async_call_holder() {if (nullptr != aci) aci->fetch_sub(1, std::memory_order_release);}
+
+	async_call_holder& operator=(const async_call_holder&) = delete;
+	async_call_holder& operator=(async_call_holder&&) = delete;
+
+private:
+	std::atomic_uint* aci;
+};
+
+//a handler which keeps a reference of the asynchronous calling indicator until itself been destroyed, it's a concrete type (no type erasure,
+// so no heap allocation like std::function) and move-only (asio always moves handlers).
+template<typename F> class tracked_handler
+{
+public:
+	template<typename T> tracked_handler(std::atomic_uint& aci, T&& handler_) : ref_holder(aci), handler(std::forward<T>(handler_)) {}
+
+	template<typename... Args> void operator()(Args&&... args) {handler(std::forward<Args>(args)...);}
+	template<typename... Args> void operator()(Args&&... args) const {handler(std::forward<Args>(args)...);}
+
+private:
+	async_call_holder ref_holder;
+	F handler;
+};
+
 class tracked_executor
 {
 protected:
@@ -26,62 +58,37 @@ protected:
 	tracked_executor(boost::asio::io_context& _io_context_) : io_context_(_io_context_) {}
 
 public:
-	typedef std::function<void(const boost::system::error_code&)> handler_with_error;
-	typedef std::function<void(const boost::system::error_code&, size_t)> handler_with_error_size;
-
 	bool stopped() const {return io_context_.stopped();}
 
-#if (_MSVC_LANG > 201103L || __cplusplus > 201103L)
-	#if BOOST_ASIO_VERSION >= 101100
-	template<typename F> void post(F&& handler) {boost::asio::post(io_context_, [ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	template<typename F> void defer(F&& handler) {boost::asio::defer(io_context_, [ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	template<typename F> void dispatch(F&& handler) {boost::asio::dispatch(io_context_, [ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	template<typename F> void post_strand(boost::asio::io_context::strand& strand, F&& handler) {boost::asio::post(strand, [ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	template<typename F> void defer_strand(boost::asio::io_context::strand& strand, F&& handler) {boost::asio::defer(strand, [ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	template<typename F> void dispatch_strand(boost::asio::io_context::strand& strand, F&& handler) {boost::asio::dispatch(strand, [ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	#else
-	template<typename F> void post(F&& handler) {io_context_.post([ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	template<typename F> void dispatch(F&& handler) {io_context_.dispatch([ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	template<typename F> void post_strand(boost::asio::io_context::strand& strand, F&& handler) {strand.post([ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	template<typename F> void dispatch_strand(boost::asio::io_context::strand& strand, F&& handler) {strand.dispatch([ref_holder(aci), handler(std::forward<F>(handler))]() {handler();});}
-	#endif
-
-	template<typename F> handler_with_error make_handler_error(F&& handler) const {return [ref_holder(aci), handler(std::forward<F>(handler))](const auto& ec) {handler(ec);};}
-	template<typename F> handler_with_error_size make_handler_error_size(F&& handler) const
-		{return [ref_holder(aci), handler(std::forward<F>(handler))](const auto& ec, auto bytes_transferred) {handler(ec, bytes_transferred);};}
+#if BOOST_ASIO_VERSION >= 101100
+	template<typename F> void post(F&& handler) {boost::asio::post(io_context_, make_tracked_handler(std::forward<F>(handler)));}
+	template<typename F> void defer(F&& handler) {boost::asio::defer(io_context_, make_tracked_handler(std::forward<F>(handler)));}
+	template<typename F> void dispatch(F&& handler) {boost::asio::dispatch(io_context_, make_tracked_handler(std::forward<F>(handler)));}
+	template<typename F> void post_strand(strand_type& strand, F&& handler) {boost::asio::post(strand, make_tracked_handler(std::forward<F>(handler)));}
+	template<typename F> void defer_strand(strand_type& strand, F&& handler) {boost::asio::defer(strand, make_tracked_handler(std::forward<F>(handler)));}
+	template<typename F> void dispatch_strand(strand_type& strand, F&& handler) {boost::asio::dispatch(strand, make_tracked_handler(std::forward<F>(handler)));}
 #else
-	#if BOOST_ASIO_VERSION >= 101100
-	template<typename F> void post(const F& handler) {auto ref_holder(aci); boost::asio::post(io_context_, [=]() {(void) ref_holder; handler();});}
-	template<typename F> void defer(const F& handler) {auto ref_holder(aci); boost::asio::defer(io_context_, [=]() {(void) ref_holder; handler();});}
-	template<typename F> void dispatch(const F& handler) {auto ref_holder(aci); boost::asio::dispatch(io_context_, [=]() {(void) ref_holder; handler();});}
-	template<typename F> void post_strand(boost::asio::io_context::strand& strand, const F& handler) {auto ref_holder(aci); boost::asio::post(strand, [=]() {(void) ref_holder; handler();});}
-	template<typename F> void defer_strand(boost::asio::io_context::strand& strand, const F& handler) {auto ref_holder(aci); boost::asio::defer(strand, [=]() {(void) ref_holder; handler();});}
-	template<typename F> void dispatch_strand(boost::asio::io_context::strand& strand, const F& handler) {auto ref_holder(aci); boost::asio::dispatch(strand, [=]() {(void) ref_holder; handler();});}
-	#else
-	template<typename F> void post(const F& handler) {auto ref_holder(aci); io_context_.post([=]() {(void) ref_holder; handler();});}
-	template<typename F> void dispatch(const F& handler) {auto ref_holder(aci); io_context_.dispatch([=]() {(void) ref_holder; handler();});}
-	template<typename F> void post_strand(boost::asio::io_context::strand& strand, const F& handler) {auto ref_holder(aci); strand.post([=]() {(void) ref_holder; handler();});}
-	template<typename F> void dispatch_strand(boost::asio::io_context::strand& strand, const F& handler) {auto ref_holder(aci); strand.dispatch([=]() {(void) ref_holder; handler();});}
-	#endif
-
-	template<typename F> handler_with_error make_handler_error(const F& handler) const {auto ref_holder(aci); return [=](const boost::system::error_code& ec) {(void) ref_holder; handler(ec);};}
-	template<typename F> handler_with_error_size make_handler_error_size(const F& handler) const
-		{auto ref_holder(aci); return [=](const boost::system::error_code& ec, size_t bytes_transferred) {(void) ref_holder; handler(ec, bytes_transferred);};}
+	template<typename F> void post(F&& handler) {io_context_.post(make_tracked_handler(std::forward<F>(handler)));}
+	template<typename F> void dispatch(F&& handler) {io_context_.dispatch(make_tracked_handler(std::forward<F>(handler)));}
+	template<typename F> void post_strand(strand_type& strand, F&& handler) {strand.post(make_tracked_handler(std::forward<F>(handler)));}
+	template<typename F> void dispatch_strand(strand_type& strand, F&& handler) {strand.dispatch(make_tracked_handler(std::forward<F>(handler)));}
 #endif
 
-#if _MSVC_LANG >= 201703L
-	bool is_async_calling() const {return aci.use_count() > 1;}
-#else
-	bool is_async_calling() const {return !aci.unique();}
-#endif
-	bool is_last_async_call() const {return aci.use_count() <= 2;} //can only be called in callbacks
+	template<typename F> tracked_handler<typename std::decay<F>::type> make_handler_error(F&& handler) const {return make_tracked_handler(std::forward<F>(handler));}
+	template<typename F> tracked_handler<typename std::decay<F>::type> make_handler_error_size(F&& handler) const {return make_tracked_handler(std::forward<F>(handler));}
+
+	bool is_async_calling() const {return aci.load(std::memory_order_acquire) > 0;}
+	bool is_last_async_call() const {return aci.load(std::memory_order_acquire) <= 1;} //can only be called in callbacks
 	inline void set_async_calling(bool) {}
 
 protected:
+	template<typename F> tracked_handler<typename std::decay<F>::type> make_tracked_handler(F&& handler) const
+		{return tracked_handler<typename std::decay<F>::type>(aci, std::forward<F>(handler));}
+
 	boost::asio::io_context& io_context_;
 
 private:
-	std::shared_ptr<char> aci{std::make_shared<char>('\0')}; //asynchronous calling indicator
+	mutable std::atomic_uint aci{0}; //asynchronous calling indicator, the number of outstanding asynchronous calls
 };
 #else
 class tracked_executor : public executor
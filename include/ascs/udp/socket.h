@@ -243,7 +243,7 @@ protected:
 	virtual bool do_send_msg(const typename super::in_msg& msg) {return false;} //customize message sending, for connected socket only
 	virtual void pre_handle_msg(typename Unpacker::container_type& msg_can) {}
 
-	void resume_sending() {this->clear_sending(); if (!send_buffer.empty()) super::send_msg();} //for reliable UDP socket only
+	void resume_sending() {this->clear_sending(); if (!this->is_send_buffer_empty()) super::send_msg();} //for reliable UDP socket only
 
 private:
 	using super::close;
@@ -327,7 +327,7 @@ private:
 
 	virtual bool do_send_msg(bool in_strand = false)
 	{
-		if (send_buffer.empty()) //without this, in extreme circumstances, messages can leave behind in the send buffer until the next message sending
+		if (this->is_send_buffer_empty()) //without this, in extreme circumstances, messages can leave behind in the send buffer until the next message sending
 		{
 			if (in_strand)
 				this->clear_sending();
@@ -338,7 +338,7 @@ private:
 			return true;
 		else if (is_connected && !check_send_cc())
 			;
-		else if (send_buffer.try_dequeue(sending_msg))
+		else if (this->try_dequeue_send_msg(sending_msg))
 		{
 			stat.send_delay_sum += statistic::now() - sending_msg.begin_time;
 			sending_msg.restart();
@@ -375,7 +375,7 @@ private:
 			this->on_msg_send(sending_msg);
 #endif
 #ifdef ASCS_WANT_ALL_MSG_SEND_NOTIFY
-			if (send_buffer.empty())
+			if (this->is_send_buffer_empty())
 				this->on_all_msg_send(sending_msg);
 #endif
 		}
@@ -394,7 +394,7 @@ private:
 		//send msg in sequence
 		//on windows, sending a msg to addr_any may cause errors, please note
 		//for UDP, sending error will not stop subsequent sending.
-		else if (!do_send_msg(true) && !send_buffer.empty())
+		else if (!do_send_msg(true) && !this->is_send_buffer_empty())
 			super::send_msg(); //just make sure no pending msgs
 	}
 
@@ -405,6 +405,8 @@ private:
 	using super::send_buffer;
 	using super::rw_strand;
 
+	//written by the IO strand, keep them away from the dispatch group at the end of ascs::socket
+	ASCS_CACHE_LINE_PADDING(io_padding)
 	bool is_bound{false}, is_connected{false}, connect_mode{ASCS_UDP_CONNECT_MODE};
 	typename super::in_msg sending_msg;
 	typename Family::endpoint local_addr;